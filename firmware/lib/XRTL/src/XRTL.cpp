@@ -134,6 +134,21 @@ bool XRTL::addModule(String moduleName, moduleType category) {
         addSuccessful = true;
         break;
     }
+    case xrtl_multiInput: {
+        module[moduleCount] = new MultiInputModule(moduleName);
+        addSuccessful = true;
+        break;
+    }
+    case xrtl_controller: {
+        module[moduleCount] = new ControllerModule(moduleName);
+        addSuccessful = true;
+        break;
+    }
+    case xrtl_motionGroup: {
+        module[moduleCount] = new MotionGroupModule(moduleName);
+        addSuccessful = true;
+        break;
+    }
     }
 
     if (addSuccessful) {
@@ -349,7 +364,7 @@ bool XRTL::settingsDialog() {
         highlightString("add module", '-');
         Serial.println("module type is determined by number, available types:");
         Serial.println("");
-        for (int i = 0; i < 9; i++) {
+        for (int i = 0; i < 12; i++) {
             Serial.printf("%d: %s\n", i, moduleNames[i]);
         }
         Serial.println("");
@@ -360,7 +375,7 @@ bool XRTL::settingsDialog() {
         choice = serialInput("send number: ");
         choiceInt = choice.toInt();
 
-        if (choice != "r" && choiceInt < 9) {
+        if (choice != "r" && choiceInt < 12) {
             moduleType newModuleType = (moduleType)choiceInt;
             String newModuleName = serialInput("new module name: ");
             if (addModule(newModuleName, newModuleType)) {
@@ -584,6 +599,16 @@ void XRTLmodule::sendCommand(XRTLcommand &command) {
     xrtl->sendCommand(command, id);
 }
 
+/**
+ * @brief locate another module on this hardware
+ * @param moduleName controlId of the module
+ * @returns pointer to the module, NULL if no module with this controlId exists
+ * @note check getType() before casting the pointer
+ */
+XRTLmodule *XRTLmodule::findModule(String &moduleName) {
+    return xrtl->operator[](moduleName);
+}
+
 /**
  *
  * @brief send internal event to all modules
@@ -759,13 +784,14 @@ void XRTL::addInternal() {
     Serial.println("");
     Serial.println("available event types:");
     Serial.println("");
-    for (int i = 0; i < 10; i++) {
+    uint8_t eventCount = sizeof(internalEventNames) / sizeof(internalEventNames[0]);
+    for (int i = 0; i < eventCount; i++) {
         Serial.printf("%d: %s\n", i, internalEventNames[i]);
     }
 
     Serial.println("");
     uint8_t choiceNum = serialInput("send number to choose event type for listener: ").toInt();
-    if (choiceNum > 11) return;
+    if (choiceNum >= eventCount) return;
     internalEvent eventType = (internalEvent)choiceNum;
 
     String listeningId = serialInput("send string to specify controlId to listen for: ");
@@ -3,9 +3,12 @@
 
 #include "common/XRTLinternalHook.h"
 #include "modules/camera/CameraModule.h"
+#include "modules/controller/ControllerModule.h"
 #include "modules/infoLED/InfoLEDModule.h"
 #include "modules/input/InputModule.h"
 #include "modules/macro/Macromodule.h"
+#include "modules/motionGroup/MotionGroupModule.h"
+#include "modules/multiInput/MultiInputModule.h"
 #include "modules/output/OutputModule.h"
 #include "modules/servo/ServoModule.h"
 #include "modules/socket/SocketModule.h"
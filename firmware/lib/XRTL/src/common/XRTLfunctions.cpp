@@ -83,4 +83,33 @@ void highlightString(String str, char filler = '-') {
  */
 float mapFloat(float x, float in_min, float in_max, float out_min, float out_max) {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-}
\ No newline at end of file
+}
+
+static const char *i2sClaim = NULL; // user of I2S0, NULL: free
+
+/**
+ * @brief reserve I2S0 for exclusive use
+ * @param owner name of the user, reported by i2sOwner()
+ * @returns false if I2S0 is used already
+ * @note the camera and the continuous ADC sampling both need I2S0, but the camera bypasses the IDF I2S driver:
+ * installing the driver succeeds while the camera runs and breaks it. Both check this claim instead.
+ */
+bool claimI2S(const char *owner) {
+    if (i2sClaim) return false;
+    i2sClaim = owner;
+    return true;
+}
+
+/**
+ * @brief hand I2S0 back after use
+ */
+void releaseI2S() {
+    i2sClaim = NULL;
+}
+
+/**
+ * @returns name of the current user of I2S0, NULL if it is free
+ */
+const char *i2sOwner() {
+    return i2sClaim;
+}
@@ -33,4 +33,10 @@ void highlightString(String str, char filler);
 
 float mapFloat(float x, float in_min, float in_max, float out_min, float out_max);
 
+bool claimI2S(const char *owner);
+
+void releaseI2S();
+
+const char *i2sOwner();
+
 #endif
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "common/XRTLfunctions.h"
 
+#define PARAMETERPACK_MAX_SIZE 20 // parameters per pack, further parameters are ignored
+
 class XRTLpar {
 protected:
     String name;
@@ -298,7 +300,7 @@ public:
 class ParameterPack {
 protected:
     uint8_t parameterCount = 0;
-    XRTLpar *parameters[16];
+    XRTLpar *parameters[PARAMETERPACK_MAX_SIZE];
     ParameterPack *parent = NULL;
     String *linkedName = NULL;
     String reserveName;
@@ -326,7 +328,7 @@ public:
     // @param unit string representing the physical meaning of the parameter (visible in query procedure)
     template <typename T>
     void add(T &linkedParameter, String paramName, String unit) {
-        if (parameterCount >= 16) return;
+        if (parameterCount >= PARAMETERPACK_MAX_SIZE) return;
 
         parameters[parameterCount++] = new XRTLparameter<T>(linkedParameter, paramName, unit);
     }
@@ -338,7 +340,7 @@ public:
     // @note parameter does not get listed and is inaccessible via serial interface, good for internal parameters
     template <typename T>
     void add(T &linkedParameter, String paramName) {
-        if (parameterCount == 16) return;
+        if (parameterCount == PARAMETERPACK_MAX_SIZE) return;
 
         parameters[parameterCount++] = new XRTLparameter<T>(linkedParameter, paramName);
     }
@@ -353,7 +355,7 @@ public:
      */
     template <typename T, typename U>
     void addDependent(T &linkedParameter, String paramName, String unit, String dependee, U condition) {
-        if (parameterCount == 16) return;
+        if (parameterCount == PARAMETERPACK_MAX_SIZE) return;
 
         XRTLpar *dependency = &operator[](dependee);
         if (dependency->isNull()) return;                                          // check if parameter exists
@@ -372,7 +374,7 @@ public:
      */
     template <typename T, typename U>
     void addDependent(T &linkedParameter, String paramName, String dependee, U condition) {
-        if (parameterCount == 16) return;
+        if (parameterCount == PARAMETERPACK_MAX_SIZE) return;
 
         XRTLpar *dependency = &operator[](dependee);
         if (dependency->isNull()) return;
@@ -0,0 +1,134 @@
+#include "XRTLpositionStream.h"
+#include "modules/XRTLmodule.h"
+
+/**
+ * @brief set the sample rate
+ * @param rate samples per second, constrained to POSITION_STREAM_MAX_RATE
+ */
+void XRTLpositionStream::setRate(uint16_t rate) {
+    sampleRate = constrain(rate, 1, POSITION_STREAM_MAX_RATE);
+    period = 1000000 / sampleRate;
+}
+
+/**
+ * @returns samples per second
+ */
+uint16_t XRTLpositionStream::rate() {
+    return sampleRate;
+}
+
+/**
+ * @brief start or stop sampling
+ * @param enabled true: sample while the motor is moving
+ * @note pending samples are discarded
+ */
+void XRTLpositionStream::enable(bool enabled) {
+    active = enabled;
+    clear();
+}
+
+bool XRTLpositionStream::enabled() {
+    return active;
+}
+
+/**
+ * @brief sample the position at the stream rate and send a block once it is complete
+ * @param module module sending the block, its id is used as controlId
+ * @param current position of the motor
+ * @param target target of the current motion
+ * @param final true: add the end position and send the pending block right away
+ * @note call in every loop while the motor is moving, does nothing while disabled
+ */
+void XRTLpositionStream::stream(XRTLmodule *module, float current, float target, bool final) {
+    if (!active) return;
+
+    int64_t now = esp_timer_get_time();
+    if (ready(now)) send(module);
+
+    if (final || due(now)) add(now, current, target);
+    if (final) send(module);
+}
+
+/**
+ * @param now current time in µs as delivered by esp_timer_get_time()
+ * @returns true if the next sample should be taken
+ */
+bool XRTLpositionStream::due(int64_t now) {
+    return active && now >= next;
+}
+
+/**
+ * @brief store a sample and schedule the next one
+ * @param now time of the sample in µs as delivered by esp_timer_get_time()
+ * @param current position of the motor
+ * @param target target of the current motion
+ * @note the sample is dropped if the block is full, send it first
+ */
+void XRTLpositionStream::add(int64_t now, float current, float target) {
+    if (count == POSITION_STREAM_LENGTH) return;
+    if (count == 0) start = now;
+
+    samples[count].time = now - start;
+    samples[count].current = current;
+    samples[count].target = target;
+    count++;
+
+    next += period;
+    if (next <= now) next = now + period; // resynchronize after a pause or a slow loop
+}
+
+/**
+ * @param now current time in µs
+ * @returns true if the block is full or its first sample is older than POSITION_STREAM_LATENCY
+ */
+bool XRTLpositionStream::ready(int64_t now) {
+    if (count == 0) return false;
+    return (count == POSITION_STREAM_LENGTH) || (now - start >= POSITION_STREAM_LATENCY);
+}
+
+/**
+ * @brief create the lead frame describing the current block
+ * @param controlId id of the sending module
+ * @param frame receives the lead frame: a socket.io binary event ("451-") whose data placeholder refers to the attachment
+ * @note send() attaches the packed samples (count * positionSample_t) as the single binary frame
+ */
+void XRTLpositionStream::leadFrame(const String &controlId, String &frame) {
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = controlId;
+    payload["type"] = "position";
+    payload["format"] = "uint32,float32,float32"; // time offset in µs, current, target
+    payload["count"] = count;
+    payload["time"] = start;
+    payload["rate"] = sampleRate;
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    frame = "451-";
+    serializeJson(doc, frame);
+}
+
+/**
+ * @brief send the collected samples as binary block
+ * @param module module sending the block
+ */
+void XRTLpositionStream::send(XRTLmodule *module) {
+    if (count == 0) return;
+
+    String frame;
+    leadFrame(module->getID(), frame);
+    module->sendBinary(frame, (uint8_t *)samples, count * sizeof(positionSample_t));
+    clear();
+}
+
+/**
+ * @brief discard the current block
+ */
+void XRTLpositionStream::clear() {
+    count = 0;
+}
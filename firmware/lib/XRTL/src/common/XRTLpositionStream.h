@@ -0,0 +1,51 @@
+#ifndef XRTLPOSITIONSTREAM_H
+#define XRTLPOSITIONSTREAM_H
+
+#include "XRTLfunctions.h"
+#include "esp_timer.h"
+
+#define POSITION_STREAM_LENGTH 64       // samples per block
+#define POSITION_STREAM_LATENCY 100000  // maximum age of the first sample in µs before a block is sent
+#define POSITION_STREAM_MAX_RATE 1000   // Hz
+
+// forward declaration: blocks are sent by the streaming module
+class XRTLmodule;
+
+// one sample as transmitted, little endian
+struct __attribute__((packed)) positionSample_t {
+    uint32_t time;  // µs since the first sample of the block
+    float current;  // position of the motor
+    float target;   // target of the current motion
+};
+
+// collects positions of a moving motor at a fixed rate and packs them into binary blocks
+// the module passes the state of its motion engine to stream() in every loop, which takes the samples that are due
+// and sends a block once it is full or old enough, so JSON is only built once per block for the lead frame
+class XRTLpositionStream {
+private:
+    positionSample_t samples[POSITION_STREAM_LENGTH];
+    uint8_t count = 0;
+    int64_t start = 0;      // esp_timer time of the first sample in the block
+    int64_t next = 0;       // time of the next sample
+    uint32_t period = 0;    // µs between two samples
+    uint16_t sampleRate = 0;
+    bool active = false;
+
+    bool due(int64_t now);
+    void add(int64_t now, float current, float target);
+    bool ready(int64_t now);
+
+    void leadFrame(const String &controlId, String &frame);
+    void send(XRTLmodule *module);
+
+public:
+    void setRate(uint16_t rate);
+    uint16_t rate();
+    void enable(bool enabled);
+    bool enabled();
+
+    void stream(XRTLmodule *module, float current, float target, bool final);
+    void clear();
+};
+
+#endif
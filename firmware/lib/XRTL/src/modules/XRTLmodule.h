@@ -14,11 +14,14 @@ enum moduleType {
     xrtl_camera,
     xrtl_input,
     xrtl_output,
-    xrtl_macro
+    xrtl_macro,
+    xrtl_multiInput,
+    xrtl_controller,
+    xrtl_motionGroup
 };
 
 // display names for modules
-static const char *moduleNames[9] =
+static const char *moduleNames[12] =
     {
         "socket",
         "wifi",
@@ -28,7 +31,10 @@ static const char *moduleNames[9] =
         "camera",
         "input",
         "output",
-        "macro"};
+        "macro",
+        "multi input",
+        "PID controller",
+        "motion group"};
 
 // used to push state changes to other modules
 enum internalEvent {
@@ -89,6 +95,7 @@ public:
     ParameterPack parameters; // stores parameters for the module
     String getID();           // return id
     String &getComponent();
+    virtual moduleType getType() = 0;
     void setLinks(XRTL *parent, bool *debugPtr);
     bool isModule(String &moduleName);
 
@@ -100,6 +107,7 @@ public:
     void sendBinary(String &binaryLeadFrame, uint8_t *payload, size_t length);
     void sendCommand(XRTLcommand &command);
     void sendStatus();
+    XRTLmodule *findModule(String &moduleName);
 
     void notify(internalEvent eventId);
     virtual void handleInternal(internalEvent eventId, String &sourceId);
@@ -0,0 +1,109 @@
+#include "BurstBuffer.h"
+
+BurstBuffer::~BurstBuffer() {
+    if (pool) free(pool);
+}
+
+/**
+ * @brief allocate the memory pool in PSRAM
+ * @param size size of the memory pool in bytes
+ * @returns true if the memory is available
+ * @note calling begin() again with the same size keeps the already allocated memory
+ */
+bool BurstBuffer::begin(size_t size) {
+    if (pool && size == poolSize) return true;
+
+    if (pool) {
+        free(pool);
+        pool = NULL;
+        poolSize = 0;
+    }
+
+    if (!psramFound()) return false;
+
+    pool = (uint8_t *)ps_malloc(size);
+    if (!pool) return false;
+
+    poolSize = size;
+    clear();
+    return true;
+}
+
+/**
+ * @brief discard all stored frames
+ */
+void BurstBuffer::clear() {
+    used = 0;
+    frameCount = 0;
+    readIndex = 0;
+}
+
+/**
+ * @brief copy a frame into the memory pool
+ * @param fb frame buffer holding the frame, must be returned to the driver by the caller
+ * @param timestamp capture time in µs
+ * @returns false if the frame did not fit into the pool anymore
+ */
+bool BurstBuffer::store(camera_fb_t *fb, int64_t timestamp) {
+    if (!pool || frameCount >= BURST_MAX_FRAMES) return false;
+    if (used + fb->len > poolSize) return false;
+
+    memcpy(pool + used, fb->buf, fb->len);
+
+    burstFrame_t &frame = frames[frameCount++];
+    frame.offset = used;
+    frame.length = fb->len;
+    frame.timestamp = timestamp;
+
+    used += fb->len;
+    return true;
+}
+
+/**
+ * @returns true if there are frames left to read
+ */
+bool BurstBuffer::available() {
+    return readIndex < frameCount;
+}
+
+/**
+ * @returns total number of frames stored
+ */
+uint8_t BurstBuffer::count() {
+    return frameCount;
+}
+
+/**
+ * @returns sequence number of the next frame to be read
+ */
+uint8_t BurstBuffer::index() {
+    return readIndex;
+}
+
+/**
+ * @brief access the next frame without removing it
+ * @note check available() first
+ */
+burstFrame_t &BurstBuffer::peek() {
+    return frames[readIndex];
+}
+
+/**
+ * @brief get the JPEG data of a frame
+ * @param frame frame obtained by peek()
+ * @returns pointer to the first byte of the JPEG
+ */
+uint8_t *BurstBuffer::data(burstFrame_t &frame) {
+    return pool + frame.offset;
+}
+
+/**
+ * @brief mark the next frame as read
+ * @note memory is only released when all frames have been read
+ */
+void BurstBuffer::pop() {
+    if (!available()) return;
+
+    readIndex++;
+    if (readIndex == frameCount) clear();
+}
@@ -0,0 +1,43 @@
+#ifndef BURSTBUFFER_H
+#define BURSTBUFFER_H
+
+#include "common/XRTLfunctions.h"
+#include <esp_camera.h>
+
+#define BURST_MAX_FRAMES 32
+
+// position of a single frame within the burst buffer
+struct burstFrame_t {
+    size_t offset;     // start of the JPEG within the memory pool
+    size_t length;     // size of the JPEG in bytes
+    int64_t timestamp; // capture time in µs
+};
+
+// stores a series of JPEG frames in PSRAM so they can be captured faster than they could be sent
+// frames are written back to back and read in the order they were stored (FIFO)
+class BurstBuffer {
+private:
+    uint8_t *pool = NULL;
+    size_t poolSize = 0;
+    size_t used = 0;
+
+    burstFrame_t frames[BURST_MAX_FRAMES];
+    uint8_t frameCount = 0; // number of frames stored
+    uint8_t readIndex = 0;  // next frame to be read
+
+public:
+    ~BurstBuffer();
+
+    bool begin(size_t size);
+    void clear();
+
+    bool store(camera_fb_t *fb, int64_t timestamp);
+    bool available();
+    uint8_t count();
+    uint8_t index();
+    burstFrame_t &peek();
+    uint8_t *data(burstFrame_t &frame);
+    void pop();
+};
+
+#endif
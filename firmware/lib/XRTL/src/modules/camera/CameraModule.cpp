@@ -5,6 +5,21 @@ CameraModule::CameraModule(String moduleName) {
 
     parameters.setKey(id);
     parameters.add(type, "type");
+
+    parameters.add(motionOnly, "motionOnly", "");
+    parameters.addDependent(motionThreshold, "motionThreshold", "0-255", "motionOnly", true);
+    parameters.addDependent(keyframeTime, "keyframeTime", "ms", "motionOnly", true);
+
+    parameters.add(autoExposure, "autoExposure", "");
+    parameters.addDependent(exposureTarget, "exposureTarget", "0-255", "autoExposure", true);
+    parameters.addDependent(exposureTolerance, "exposureTolerance", "2-127", "autoExposure", true);
+
+    parameters.add(previewMode, "previewMode", "");
+    parameters.addDependent(previewScale, "previewScale", "2/4/8", "previewMode", true);
+    parameters.addDependent(previewQuality, "previewQuality", "1-100", "previewMode", true);
+
+    parameters.add(burstMemory, "burstMemory", "kB");
+    parameters.add(ptzTransition, "ptzTransition", "ms");
 }
 
 moduleType CameraModule::getType() {
@@ -45,11 +60,25 @@ camera_config_t CameraModule::camera_config = {
 };
 
 void CameraModule::setup() {
+    // the camera drives I2S0 directly, continuous ADC sampling must not install its driver on top
+    if (!claimI2S("camera")) {
+        initStatus = ESP_ERR_INVALID_STATE;
+        debug("camera init failed: I2S0 used by %s", i2sOwner());
+        String errmsg = "[";
+        errmsg += id.c_str();
+        errmsg += "] unable to initialize camera: I2S0 used by ";
+        errmsg += i2sOwner();
+        sendError(hardware_failure, errmsg);
+
+        return;
+    }
+
     // initialize the camera
     initStatus = esp_camera_init(&camera_config);
     if (initStatus != ESP_OK) {
         // debug("camera init failed: %s", err); // TODO: investigate core panic if init failed after restart
         debug("camera init failed");
+        releaseI2S();
         String errmsg = "[";
         errmsg += id.c_str();
         errmsg += "] unable to initialize camera hardware";
@@ -63,14 +92,33 @@ void CameraModule::setup() {
     cameraSettings->set_gain_ctrl(cameraSettings, 0);
     cameraSettings->set_exposure_ctrl(cameraSettings, 0);
     cameraSettings->set_aec_value(cameraSettings, exposure);
+    cameraSettings->set_agc_gain(cameraSettings, gain);
+    buildPTZtable();
     debug("camera initialized");
 }
 
 void CameraModule::loop() {
-    if (!isStreaming || initStatus != ESP_OK) return;
+    if (initStatus != ESP_OK) return;
+
+    if (ptzMoving) {
+        animatePTZ(esp_timer_get_time());
+    }
+
+    // a burst takes precedence over the stream: capture first, upload afterwards
+    if (burstRemaining > 0) {
+        captureBurst();
+        return;
+    }
+
+    if (burst.available()) {
+        uploadBurst();
+        return;
+    }
+
+    if (!isStreaming && !snapshotRequested) return;
 
     int64_t now = esp_timer_get_time();
-    if (now < nextFrame) return;
+    if (now < nextFrame && !snapshotRequested) return;
 
     camera_fb_t *fb = esp_camera_fb_get();
     if (!fb) {
@@ -80,17 +128,94 @@ void CameraModule::loop() {
         errmsg += "] unable to obtain camera buffer, closing stream";
         sendError(hardware_failure, errmsg);
 
+        snapshotRequested = false;
         stopStreaming();
         return;
     }
 
-    sendBinary(binaryLeadFrame, fb->buf, fb->len);
+    if (snapshotRequested) {
+        sendSnapshot(fb);
+        esp_camera_fb_return(fb);
+        return;
+    }
+
+    // the analysis is shared by motion detection and exposure control, decode only once
+    bool analyzed = false;
+    if (motionOnly || autoExposure) {
+        analyzed = analyzer.analyze(fb);
+    }
+
+    if (autoExposure && analyzed) {
+        adjustExposure();
+    }
+
+    if (motionOnly && analyzed && !frameChanged(now)) {
+        esp_camera_fb_return(fb);
+        nextFrame = now + frameTimeMicroSeconds;
+        return;
+    }
+
+    sendFrame(fb);
     esp_camera_fb_return(fb);
     // debug("time needed to send image: %f ms", (double) (esp_timer_get_time() - now)/1000);
 
     nextFrame = now + frameTimeMicroSeconds;
 }
 
+/**
+ * @brief send a frame of the stream, downscaled if in preview mode
+ * @param fb frame buffer holding the current frame
+ * @note if the preview can not be created, the full frame is sent instead
+ */
+void CameraModule::sendFrame(camera_fb_t *fb) {
+    if (previewMode && preview.encode(fb, previewScale, isGray, previewQuality)) {
+        sendBinary(binaryLeadFrame, preview.data(), preview.length());
+        preview.release();
+    } else {
+        if (previewMode) debug("unable to create preview, sending full frame");
+        sendBinary(binaryLeadFrame, fb->buf, fb->len);
+    }
+
+    finishSwitch();
+}
+
+/**
+ * @brief send a single frame at full resolution, independent of preview mode and stream
+ * @param fb frame buffer holding the frame
+ */
+void CameraModule::sendSnapshot(camera_fb_t *fb) {
+    snapshotRequested = false;
+
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "snapshot";
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    sendBinary(leadFrame, fb->buf, fb->len);
+    finishSwitch();
+}
+
+/**
+ * @brief complete the timing measurement of a frame size or mode change, if one is running
+ */
+void CameraModule::finishSwitch() {
+    if (switchStart == 0) return;
+
+    switchTime = esp_timer_get_time() - switchStart;
+    switchStart = 0;
+    debug("first frame after change sent after %f ms", (double)switchTime / 1000);
+}
+
 bool CameraModule::getStatus(JsonObject &status) {
     if (initStatus != ESP_OK) {
         String errmsg = "[";
@@ -106,7 +231,16 @@ bool CameraModule::getStatus(JsonObject &status) {
     status["gray"] = isGray;
     // status["brightness"] = brightness;
     status["exposure"] = exposure;
+    status["gain"] = gain;
+    status["pan"] = pan;
+    status["tilt"] = tilt;
+    status["zoom"] = zoom;
+    status["autoExposure"] = autoExposure;
     status["contrast"] = contrast;
+    status["motionOnly"] = motionOnly;
+    status["preview"] = previewMode;
+    status["switchTime"] = (double)switchTime / 1000; // ms
+    status["burst"] = (burstRemaining > 0 || burst.available());
 
     return true;
 }
@@ -153,6 +287,7 @@ void CameraModule::startStreaming() {
     isStreaming = true;
     sendStatus();
 
+    analyzer.clearReference(); // always deliver the first frame
     nextFrame = esp_timer_get_time();
 }
 
@@ -167,24 +302,311 @@ void CameraModule::stopStreaming() {
     sendStatus();
 }
 
+/**
+ * @brief decide whether the last analyzed frame differs enough from the last frame sent to be worth sending
+ * @param now current time in µs
+ * @returns true if the frame should be sent
+ * @note a keyframe is sent after keyframeTime even if nothing changed
+ */
+bool CameraModule::frameChanged(int64_t now) {
+    if (now < nextKeyframe && analyzer.difference() < motionThreshold) return false;
+
+    analyzer.setReference();
+    nextKeyframe = now + 1000 * (int64_t)keyframeTime;
+    return true;
+}
+
+/**
+ * @brief single step of the exposure control, based on the luminance of the last analyzed frame
+ * @note exposure is scaled by target/mean (at most by a factor of 2 per step), gain is only used once the exposure is maxed out.
+ * Adjustments start if the mean deviates more than exposureTolerance from the target and stop within half of that band.
+ */
+void CameraModule::adjustExposure() {
+    if (exposureSettle > 0) { // the sensor needs some frames until changes take effect
+        exposureSettle--;
+        return;
+    }
+
+    int16_t deviation = (int16_t)analyzer.mean() - (int16_t)exposureTarget;
+    bool saturated = analyzer.saturation() > 5; // more than 5 % of the image clipped
+    uint8_t band = exposureAdjusting ? exposureTolerance / 2 : exposureTolerance;
+
+    if (abs(deviation) <= band && !saturated) {
+        if (exposureAdjusting) {
+            exposureAdjusting = false;
+            debug("exposure settled at %d, gain %d", exposure, gain);
+            sendStatus();
+        }
+        return;
+    }
+    exposureAdjusting = true;
+
+    int32_t targetExposure = (int32_t)max(exposure, 1) * exposureTarget / max((int)analyzer.mean(), 1);
+    if (saturated && targetExposure >= exposure) {
+        targetExposure = exposure * 3 / 4;
+    }
+    targetExposure = constrain(targetExposure, max(exposure, 1) / 2, max(exposure, 1) * 2);
+
+    int targetGain = gain;
+    if (targetExposure > 1200) { // too dark even at maximum exposure
+        targetExposure = 1200;
+        targetGain = min(gain + 2, 30);
+    } else if (targetExposure < exposure && gain > 0) { // too bright: drop gain first to keep the noise low
+        targetExposure = exposure;
+        targetGain = max(gain - 2, 0);
+    }
+    targetExposure = constrain(targetExposure, 0, 1200);
+
+    if (targetExposure == exposure && targetGain == gain) return; // limits reached
+
+    if (targetExposure != exposure) {
+        exposure = targetExposure;
+        cameraSettings->set_aec_value(cameraSettings, exposure);
+    }
+    if (targetGain != gain) {
+        gain = targetGain;
+        cameraSettings->set_agc_gain(cameraSettings, gain);
+    }
+
+    exposureSettle = 2;
+}
+
+/**
+ * @brief start capturing a series of frames at the maximum rate of the sensor
+ * @param frameCount number of frames to capture
+ * @note frames are stored in PSRAM and uploaded one per loop after the capture is complete
+ */
+void CameraModule::startBurst(uint8_t frameCount) {
+    if (burstRemaining > 0 || burst.available()) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] burst rejected: previous burst still in progress";
+        sendError(is_busy, errmsg);
+        return;
+    }
+
+    if (!burst.begin(1024 * (size_t)burstMemory)) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate burst buffer in PSRAM";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    burstStart = esp_timer_get_time();
+    burstRemaining = frameCount;
+    debug("capturing burst of %d frames", frameCount);
+    sendStatus();
+    notify(busy);
+}
+
+/**
+ * @brief capture a single frame of the current burst
+ */
+void CameraModule::captureBurst() {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+        debug("buffer invalid");
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to obtain camera buffer, burst aborted";
+        sendError(hardware_failure, errmsg);
+
+        burstRemaining = 0;
+        burst.clear();
+        sendStatus();
+        notify(ready);
+        return;
+    }
+
+    // the driver stamps frames with esp_timer_get_time() at the end of the capture
+    int64_t timestamp = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    bool stored = burst.store(fb, timestamp);
+    esp_camera_fb_return(fb);
+
+    if (stored) {
+        burstRemaining--;
+    } else {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] burst buffer full after ";
+        errmsg += burst.count();
+        errmsg += " frames";
+        sendError(out_of_bounds, errmsg);
+        burstRemaining = 0;
+    }
+
+    if (burstRemaining == 0) {
+        debug("burst captured: %d frames in %f ms", burst.count(), (double)(esp_timer_get_time() - burstStart) / 1000);
+    }
+}
+
+/**
+ * @brief send the next frame of a captured burst
+ * @note the lead frame holds the sequence number, the total number of frames and the capture time relative to the trigger in µs
+ */
+void CameraModule::uploadBurst() {
+    burstFrame_t &frame = burst.peek();
+
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "burst";
+    payload["seq"] = burst.index();
+    payload["count"] = burst.count();
+    payload["time"] = (long)(frame.timestamp - burstStart);
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    sendBinary(leadFrame, burst.data(frame), frame.length);
+    burst.pop();
+
+    if (burst.available()) return;
+
+    debug("burst uploaded");
+    sendStatus();
+    notify(ready);
+}
+
+/**
+ * @brief precompute the PTZ windows of all pan, tilt and zoom stages for the sensor in use
+ * @note window size: sensor size / zoom factor; offset: stage * (sensor size - window size) / 9
+ */
+void CameraModule::buildPTZtable() {
+    camera_sensor_info_t *info = esp_camera_sensor_get_info(&cameraSettings->id);
+    if (info) {
+        sensorWidth = resolution[info->max_size].width;
+        sensorHeight = resolution[info->max_size].height;
+    }
+
+    for (int zoomIndex = 0; zoomIndex < PTZ_ZOOM_STAGES; zoomIndex++) {
+        uint32_t relativeLength = ptzRelativeLength(zoomIndex);
+        ptzLength[zoomIndex][0] = ((uint32_t)sensorWidth * relativeLength) >> 16;
+        ptzLength[zoomIndex][1] = ((uint32_t)sensorHeight * relativeLength) >> 16;
+
+        for (int stage = 0; stage < PTZ_PAN_STAGES; stage++) {
+            // offsets are rounded: add half of the divisor before dividing
+            uint64_t factor = (uint64_t)(65536 - relativeLength) * stage;
+            ptzOffset[zoomIndex][stage][0] = ((uint64_t)sensorWidth * factor + 9 * 32768) / (9 * 65536);
+            ptzOffset[zoomIndex][stage][1] = ((uint64_t)sensorHeight * factor + 9 * 32768) / (9 * 65536);
+        }
+    }
+
+    ptzCurrent.xOffset = 0;
+    ptzCurrent.yOffset = 0;
+    ptzCurrent.xLength = sensorWidth;
+    ptzCurrent.yLength = sensorHeight;
+
+    debug("PTZ table created for %dx%d sensor", sensorWidth, sensorHeight);
+}
+
+/**
+ * @brief move the window to the current pan, tilt and zoom stages
+ */
 void CameraModule::virtualPTZ() {
-    // equations
-    // xOffset = panStage * [ width/(N-1) * (1- 1/zoomFactor) ]
-    // yOffset = tiltStage * [ height/(N-1) * (1 - 1/zoomFactor) ]
-    // xLength = width / zoomFactor
-    // yLength = height / zoomFactor
-
-    // set zoom factor, use to calculate width and height
-    float zoomFactor = 1.0 + zoomStage * 3.0;
-    uint16_t xLength = floor(1600.0 / zoomFactor);
-    uint16_t yLength = floor(1200.0 / zoomFactor);
-
-    // re-use zoomFactor for offset calculation (common factor of 1-1/zoomFactor)
-    zoomFactor = 1.0 - 1.0 / zoomFactor;
-    uint16_t xOffset = round(zoomFactor * 177.78 * (float)panStage);
-    uint16_t yOffset = round(zoomFactor * 133.33 * (float)tiltStage);
-
-    cameraSettings->set_res_raw(cameraSettings, 0, 0, 0, 0, xOffset, yOffset, xLength, yLength, xLength, yLength, true, true);
+    ptzWindow_t target;
+    target.xLength = ptzLength[zoomStage][0];
+    target.yLength = ptzLength[zoomStage][1];
+    target.xOffset = ptzOffset[zoomStage][panStage][0];
+    target.yOffset = ptzOffset[zoomStage][tiltStage][1];
+
+    // keep the continuous coordinates in sync with the stages
+    zoom = 1.0 + 3.0 * zoomStage;
+    pan = 100.0 * panStage / PTZ_PAN_STAGES;
+    tilt = 100.0 * tiltStage / PTZ_PAN_STAGES;
+
+    moveWindow(target);
+}
+
+/**
+ * @brief move the window to absolute coordinates
+ * @param targetPan horizontal position in % of the available range
+ * @param targetTilt vertical position in % of the available range
+ * @param targetZoom zoom factor, 1 shows the whole sensor
+ */
+void CameraModule::virtualPTZ(float targetPan, float targetTilt, float targetZoom) {
+    pan = targetPan;
+    tilt = targetTilt;
+    zoom = targetZoom;
+
+    // snap the stages to the nearest ones, relative steps continue from there
+    panStage = constrain(lround(pan * PTZ_PAN_STAGES / 100.0), 0L, (long)PTZ_PAN_STAGES - 1);
+    tiltStage = constrain(lround(tilt * PTZ_PAN_STAGES / 100.0), 0L, (long)PTZ_PAN_STAGES - 1);
+    zoomStage = constrain(lround((zoom - 1.0) / 3.0), 0L, (long)PTZ_ZOOM_STAGES - 1);
+
+    ptzWindow_t target;
+    target.xLength = sensorWidth / zoom;
+    target.yLength = sensorHeight / zoom;
+    target.xOffset = round((sensorWidth - target.xLength) * pan / 100.0);
+    target.yOffset = round((sensorHeight - target.yLength) * tilt / 100.0);
+
+    moveWindow(target);
+}
+
+/**
+ * @brief start the transition to a new window
+ * @param target window to move to
+ * @note status is sent once the transition is complete
+ */
+void CameraModule::moveWindow(ptzWindow_t &target) {
+    ptzTarget = target;
+
+    if (ptzTransition == 0) {
+        ptzCurrent = target;
+        applyWindow(ptzCurrent);
+        ptzMoving = false;
+        sendStatus();
+        return;
+    }
+
+    ptzStart = ptzCurrent;
+    ptzStartTime = esp_timer_get_time();
+    nextPtzStep = ptzStartTime;
+    ptzMoving = true;
+}
+
+/**
+ * @brief write a window to the sensor
+ * @param window section of the sensor to use
+ */
+void CameraModule::applyWindow(ptzWindow_t &window) {
+    cameraSettings->set_res_raw(cameraSettings, 0, 0, 0, 0, window.xOffset, window.yOffset, window.xLength, window.yLength, window.xLength, window.yLength, true, true);
+}
+
+/**
+ * @brief advance the current transition, the window is updated at most once per frame time
+ * @param now current time in µs
+ */
+void CameraModule::animatePTZ(int64_t now) {
+    if (now < nextPtzStep) return;
+    nextPtzStep = now + min(frameTimeMicroSeconds, (uint32_t)40000);
+
+    int64_t elapsed = now - ptzStartTime;
+    int64_t duration = 1000 * (int64_t)ptzTransition;
+    if (elapsed >= duration) {
+        ptzCurrent = ptzTarget;
+        applyWindow(ptzCurrent);
+        ptzMoving = false;
+        debug("PTZ window: %d,%d %dx%d", ptzCurrent.xOffset, ptzCurrent.yOffset, ptzCurrent.xLength, ptzCurrent.yLength);
+        sendStatus();
+        return;
+    }
+
+    // linear interpolation between start and target (fraction in Q16)
+    int32_t fraction = (elapsed << 16) / duration;
+    ptzCurrent.xOffset = ptzStart.xOffset + ((((int32_t)ptzTarget.xOffset - ptzStart.xOffset) * fraction) >> 16);
+    ptzCurrent.yOffset = ptzStart.yOffset + ((((int32_t)ptzTarget.yOffset - ptzStart.yOffset) * fraction) >> 16);
+    ptzCurrent.xLength = ptzStart.xLength + ((((int32_t)ptzTarget.xLength - ptzStart.xLength) * fraction) >> 16);
+    ptzCurrent.yLength = ptzStart.yLength + ((((int32_t)ptzTarget.yLength - ptzStart.yLength) * fraction) >> 16);
+    applyWindow(ptzCurrent);
 }
 
 void CameraModule::handleCommand(String &controlId, JsonObject &command) {
@@ -221,14 +643,25 @@ void CameraModule::handleCommand(String &controlId, JsonObject &command) {
         sendStatus();
     }
 
-    int gain;
+    if (getValue<bool>("autoExposure", command, autoExposure)) {
+        exposureAdjusting = false;
+        exposureSettle = 0;
+        debug("automatic exposure %sabled", autoExposure ? "en" : "dis");
+        sendStatus();
+    }
+
+    getValue<uint8_t>("exposureTarget", command, exposureTarget);
+    getAndConstrainValue<uint8_t>("exposureTolerance", command, exposureTolerance, 2, 127);
+
     if (getAndConstrainValue<int>("gain", command, gain, 0, 30)) {
+        autoExposure = false; // manual setting overrides the controller
         cameraSettings->set_gain_ctrl(cameraSettings, 0);
         cameraSettings->set_agc_gain(cameraSettings, gain);
         debug("gain changed to %d", gain);
     }
 
     if (getAndConstrainValue<int>("exposure", command, exposure, 0, 1200)) {
+        autoExposure = false; // manual setting overrides the controller
         cameraSettings->set_gain_ctrl(cameraSettings, 0);
         cameraSettings->set_exposure_ctrl(cameraSettings, 0);
         cameraSettings->set_aec_value(cameraSettings, exposure);
@@ -252,39 +685,83 @@ void CameraModule::handleCommand(String &controlId, JsonObject &command) {
     if (getValue<int8_t>("virtualPan", command, virtualPTZtarget)) {
         if (virtualPTZtarget > 0) {
             panStage++;
-        } else if (virtualPTZtarget < 0) {
+        } else if (virtualPTZtarget < 0 && panStage > 0) { // avoid wrapping around
             panStage--;
         }
         panStage = constrain(panStage, 0, 8);
         virtualPTZ();
         debug("pan stage set to %d", panStage);
-        sendStatus();
     }
 
     if (getValue<int8_t>("virtualTilt", command, virtualPTZtarget)) {
         if (virtualPTZtarget > 0) {
             tiltStage++;
-        } else if (virtualPTZtarget < 0) {
+        } else if (virtualPTZtarget < 0 && tiltStage > 0) { // avoid wrapping around
             tiltStage--;
         }
         tiltStage = constrain(tiltStage, 0, 8);
         virtualPTZ();
         debug("tilt stage set to %d", tiltStage);
-        sendStatus();
     }
 
     if (getValue<int8_t>("virtualZoom", command, virtualPTZtarget)) {
         if (virtualPTZtarget > 0) {
             zoomStage++;
-        } else if (virtualPTZtarget < 0) {
+        } else if (virtualPTZtarget < 0 && zoomStage > 0) { // avoid wrapping around
             zoomStage--;
         }
         zoomStage = constrain(zoomStage, 0, 4);
         virtualPTZ();
         debug("zoom stage set to %d", zoomStage);
+    }
+
+    if (getValue<bool>("snapshot", command, snapshotRequested) && snapshotRequested) {
+        switchStart = esp_timer_get_time();
+    }
+
+    if (getValue<bool>("preview", command, previewMode)) {
+        if (isStreaming) switchStart = esp_timer_get_time();
+        debug("preview mode %sabled", previewMode ? "en" : "dis");
+        sendStatus();
+    }
+
+    if (getValue<uint8_t>("previewScale", command, previewScale)) {
+        if (previewScale != 2 && previewScale != 4 && previewScale != 8) {
+            String errormsg = "[";
+            errormsg += id;
+            errormsg += "] <previewScale> must be 2, 4 or 8";
+            sendError(out_of_bounds, errormsg);
+            previewScale = 4;
+        }
+    }
+
+    uint8_t burstCount;
+    if (getAndConstrainValue<uint8_t>("burst", command, burstCount, 1, BURST_MAX_FRAMES)) {
+        startBurst(burstCount);
+    }
+
+    if (getValue<bool>("motionOnly", command, motionOnly)) {
+        analyzer.clearReference();
+        debug("motion detection %sabled", motionOnly ? "en" : "dis");
         sendStatus();
     }
 
+    getAndConstrainValue<uint8_t>("motionThreshold", command, motionThreshold, 1, 255);
+    getValue<uint32_t>("keyframeTime", command, keyframeTime);
+
+    JsonObject ptzCommand;
+    if (getValue<JsonObject>("ptz", command, ptzCommand)) {
+        float targetPan = pan;
+        float targetTilt = tilt;
+        float targetZoom = zoom;
+        getAndConstrainValue<float>("pan", ptzCommand, targetPan, 0, 100);
+        getAndConstrainValue<float>("tilt", ptzCommand, targetTilt, 0, 100);
+        getAndConstrainValue<float>("zoom", ptzCommand, targetZoom, 1, 13);
+        virtualPTZ(targetPan, targetTilt, targetZoom);
+    }
+
+    getValue<uint16_t>("ptzTransition", command, ptzTransition);
+
     double targetFrameRate = 15;
     if (getAndConstrainValue<double>("frame rate", command, targetFrameRate, 0, 30)) {
         frameTimeMicroSeconds = round((double)1000000 / targetFrameRate);
@@ -304,6 +781,7 @@ void CameraModule::handleCommand(String &controlId, JsonObject &command) {
         }
 
         frameSize = (framesize_t)targetFrameSize;
+        if (isStreaming) switchStart = esp_timer_get_time();
         cameraSettings->set_framesize(cameraSettings, frameSize);
         debug("frame size changed to %d", targetFrameSize);
         sendStatus();
@@ -314,6 +792,13 @@ void CameraModule::handleCommand(String &controlId, JsonObject &command) {
 void CameraModule::handleInternal(internalEvent eventId, String &sourceId) {
     switch (eventId) {
     case socket_disconnected: {
+        if (burstRemaining > 0 || burst.available()) {
+            burstRemaining = 0;
+            burst.clear();
+            debug("burst discarded due to disconnect");
+            notify(ready);
+        }
+
         // TODO: suspend stream instead of stopping?
         if (!isStreaming)
             return;
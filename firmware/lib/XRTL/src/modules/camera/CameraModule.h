@@ -1,9 +1,28 @@
 #ifndef CAMERAMODULE_H
 #define CAMERAMODULE_H
 
+#include "BurstBuffer.h"
+#include "FrameAnalyzer.h"
+#include "PreviewEncoder.h"
 #include "modules/XRTLmodule.h"
 #include <esp_camera.h>
 
+#define PTZ_PAN_STAGES 9  // number of pan and tilt stages
+#define PTZ_ZOOM_STAGES 5 // number of zoom stages
+
+// relative size of the PTZ window for each zoom stage as fraction of the full sensor (Q16), zoom factor: 1 + 3 * stage
+constexpr uint32_t ptzRelativeLength(uint8_t zoomStage) {
+    return 65536 / (1 + 3 * zoomStage);
+}
+
+// section of the sensor used as virtual PTZ window, in pixels
+struct ptzWindow_t {
+    uint16_t xOffset;
+    uint16_t yOffset;
+    uint16_t xLength;
+    uint16_t yLength;
+};
+
 class CameraModule : public XRTLmodule {
 private:
     esp_err_t initStatus;
@@ -13,6 +32,37 @@ private:
     uint32_t frameTimeMicroSeconds = 100000; // minimum time interval between frames in µs; time might be higher due to load
     String binaryLeadFrame;                  // content of websocket text frame to be send prior to binary data
 
+    // motion detection: suppress frames that do not differ from the last frame sent
+    bool motionOnly = false;
+    uint8_t motionThreshold = 8;   // luminance difference (0-255) of a single grid cell that counts as change
+    uint32_t keyframeTime = 5000;  // maximum time between two frames in ms, even if nothing changed
+    int64_t nextKeyframe = 0;      // µs
+    FrameAnalyzer analyzer;
+
+    // automatic exposure: adjust exposure and gain until the mean luminance matches the target
+    bool autoExposure = false;
+    uint8_t exposureTarget = 110;  // mean luminance (0-255) the controller aims for
+    uint8_t exposureTolerance = 12; // deviation from the target that triggers an adjustment, adjusting stops within half of it
+    uint8_t exposureSettle = 0;    // frames to skip until the last adjustment becomes visible
+    bool exposureAdjusting = false;
+
+    // preview mode: the sensor stays at frameSize, the stream is downscaled on the device
+    bool previewMode = false;
+    uint8_t previewScale = 4;    // downscaling factor of the preview: 2, 4 or 8
+    uint8_t previewQuality = 60; // JPEG quality of the preview (1-100, higher is better)
+    bool snapshotRequested = false;
+    PreviewEncoder preview;
+
+    // timing of the last frame size or mode change
+    int64_t switchStart = 0;  // time the change was requested, 0 if no measurement is running; µs
+    uint32_t switchTime = 0;  // time until the first frame after the change was sent; µs
+
+    // burst capture: frames are captured at sensor rate into PSRAM and uploaded afterwards
+    uint16_t burstMemory = 2048; // size of the burst buffer in kB
+    uint8_t burstRemaining = 0;  // frames still to be captured
+    int64_t burstStart = 0;      // time the burst was triggered; µs
+    BurstBuffer burst;
+
     static camera_config_t camera_config;
     sensor_t *cameraSettings = NULL;
 
@@ -20,12 +70,31 @@ private:
     uint8_t panStage = 4;
     uint8_t tiltStage = 4;
     uint8_t zoomStage = 0;
+    float pan = 44.44;  // horizontal window position in % of the available range
+    float tilt = 44.44; // vertical window position in % of the available range
+    float zoom = 1.0;   // zoom factor
+
+    // window table for the stages, filled for the actual sensor size during setup
+    uint16_t sensorWidth = 1600;
+    uint16_t sensorHeight = 1200;
+    uint16_t ptzLength[PTZ_ZOOM_STAGES][2];              // window width and height per zoom stage
+    uint16_t ptzOffset[PTZ_ZOOM_STAGES][PTZ_PAN_STAGES][2]; // window x and y offset per zoom and pan/tilt stage
+
+    // animated transitions between windows
+    uint16_t ptzTransition = 300; // duration of a transition in ms, 0: change window immediately
+    bool ptzMoving = false;
+    int64_t ptzStartTime = 0;     // µs
+    int64_t nextPtzStep = 0;      // µs
+    ptzWindow_t ptzCurrent;
+    ptzWindow_t ptzStart;
+    ptzWindow_t ptzTarget;
 
     // camera settings
     bool isGray = false;
     int brightness = 0;
     int contrast = 0;
     int exposure = 200;
+    int gain = 0;
     framesize_t frameSize = FRAMESIZE_QVGA;
 
 public:
@@ -43,13 +112,28 @@ public:
 
     void startStreaming();
     void stopStreaming();
+    bool frameChanged(int64_t now);
+    void adjustExposure();
+
+    void sendFrame(camera_fb_t *fb);
+    void sendSnapshot(camera_fb_t *fb);
+    void finishSwitch();
+
+    void startBurst(uint8_t frameCount);
+    void captureBurst();
+    void uploadBurst();
     
     void handleCommand(String &controlId, JsonObject &command);
     void handleInternal(internalEvent eventId, String &sourceId);
 
     // void getStatus();
 
+    void buildPTZtable();
     void virtualPTZ();
+    void virtualPTZ(float targetPan, float targetTilt, float targetZoom);
+    void moveWindow(ptzWindow_t &target);
+    void applyWindow(ptzWindow_t &window);
+    void animatePTZ(int64_t now);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "FrameAnalyzer.h"
+
+/**
+ * @brief reader callback of the JPEG decoder, hands out the compressed frame
+ * @param arg pointer to the FrameAnalyzer
+ * @param index position in the JPEG data
+ * @param buf copy the data here, NULL if the data is supposed to be skipped
+ * @param len number of bytes requested
+ * @returns number of bytes delivered
+ */
+size_t frameAnalyzerRead(void *arg, size_t index, uint8_t *buf, size_t len) {
+    FrameAnalyzer *analyzer = (FrameAnalyzer *)arg;
+    if (buf) {
+        memcpy(buf, analyzer->input + index, len);
+    }
+    return len;
+}
+
+/**
+ * @brief writer callback of the JPEG decoder, accumulates the luminance of the decoded blocks in the grid cells
+ * @param arg pointer to the FrameAnalyzer
+ * @param x horizontal position of the block
+ * @param y vertical position of the block
+ * @param w width of the block
+ * @param h height of the block
+ * @param data RGB888 data of the block, NULL when decoding starts or ends
+ * @returns true if decoding should continue
+ */
+bool frameAnalyzerWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+    FrameAnalyzer *analyzer = (FrameAnalyzer *)arg;
+    if (!data) {
+        if (x == 0 && y == 0) { // decoding starts, dimensions of the scaled image are supplied
+            analyzer->width = w;
+            analyzer->height = h;
+        }
+        return true;
+    }
+
+    if (analyzer->width == 0 || analyzer->height == 0) return false;
+
+    for (uint16_t iy = y; iy < y + h; iy++) {
+        uint16_t row = (uint32_t)iy * FRAME_GRID_HEIGHT / analyzer->height * FRAME_GRID_WIDTH;
+        for (uint16_t ix = x; ix < x + w; ix++) {
+            uint16_t cell = row + (uint32_t)ix * FRAME_GRID_WIDTH / analyzer->width;
+            // ITU-R BT.601 luma, integer approximation
+            uint8_t luminance = (77 * data[0] + 150 * data[1] + 29 * data[2]) >> 8;
+            analyzer->cellSum[cell] += luminance;
+            analyzer->cellCount[cell]++;
+            analyzer->histogram[luminance * FRAME_HISTOGRAM_BINS / 256]++;
+            data += 3;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief calculate the luminance signature of a frame
+ * @param fb frame buffer holding a JPEG image
+ * @returns true if the frame could be analyzed
+ * @note the frame is decoded at 1/8 scale, which takes a fraction of the time needed for a full decode
+ */
+bool FrameAnalyzer::analyze(camera_fb_t *fb) {
+    if (!fb || fb->format != PIXFORMAT_JPEG) return false;
+
+    memset(cellSum, 0, sizeof(cellSum));
+    memset(cellCount, 0, sizeof(cellCount));
+    memset(histogram, 0, sizeof(histogram));
+    input = fb->buf;
+    width = 0;
+    height = 0;
+
+    esp_err_t decodeStatus = esp_jpg_decode(fb->len, JPG_SCALE_8X, frameAnalyzerRead, frameAnalyzerWrite, this);
+    input = NULL;
+    if (decodeStatus != ESP_OK) return false;
+
+    uint32_t totalSum = 0;
+    pixelCount = 0;
+    for (int i = 0; i < FRAME_GRID_CELLS; i++) {
+        totalSum += cellSum[i];
+        pixelCount += cellCount[i];
+
+        if (cellCount[i] == 0) {
+            signature[i] = 0;
+            continue;
+        }
+        signature[i] = cellSum[i] / cellCount[i];
+    }
+
+    meanLuminance = pixelCount > 0 ? totalSum / pixelCount : 0;
+    return true;
+}
+
+/**
+ * @brief compare the signature of the last analyzed frame with the reference
+ * @returns largest luminance difference (0-255) found in any of the grid cells
+ * @note returns 255 if no reference has been set yet. Using the largest difference instead of the mean keeps small moving objects detectable, noise is already averaged within each cell.
+ */
+uint8_t FrameAnalyzer::difference() {
+    if (!hasReference) return 255;
+
+    uint8_t maxDifference = 0;
+    for (int i = 0; i < FRAME_GRID_CELLS; i++) {
+        uint8_t cellDifference = abs((int16_t)signature[i] - (int16_t)reference[i]);
+        if (cellDifference > maxDifference) maxDifference = cellDifference;
+    }
+
+    return maxDifference;
+}
+
+/**
+ * @returns mean luminance (0-255) of the last analyzed frame
+ */
+uint8_t FrameAnalyzer::mean() {
+    return meanLuminance;
+}
+
+/**
+ * @returns percentage of pixels of the last analyzed frame that fall into the brightest histogram bin
+ * @note the brightest bin starts at 248, these pixels are considered saturated
+ */
+uint8_t FrameAnalyzer::saturation() {
+    if (pixelCount == 0) return 0;
+    return 100 * histogram[FRAME_HISTOGRAM_BINS - 1] / pixelCount;
+}
+
+/**
+ * @brief use the signature of the last analyzed frame as reference for future comparisons
+ */
+void FrameAnalyzer::setReference() {
+    memcpy(reference, signature, FRAME_GRID_CELLS);
+    hasReference = true;
+}
+
+/**
+ * @brief discard the reference, the next comparison will report a maximal difference
+ */
+void FrameAnalyzer::clearReference() {
+    hasReference = false;
+}
@@ -0,0 +1,49 @@
+#ifndef FRAMEANALYZER_H
+#define FRAMEANALYZER_H
+
+#include "common/XRTLfunctions.h"
+#include <esp_camera.h>
+#include <esp_jpg_decode.h>
+
+// resolution of the luminance signature, every cell holds the mean luminance of its part of the image
+#define FRAME_GRID_WIDTH 16
+#define FRAME_GRID_HEIGHT 12
+#define FRAME_GRID_CELLS (FRAME_GRID_WIDTH * FRAME_GRID_HEIGHT)
+// number of bins of the luminance histogram, each bin covers 256 / FRAME_HISTOGRAM_BINS luminance values
+#define FRAME_HISTOGRAM_BINS 32
+
+// decode JPEG frames at 1/8 scale and derive luminance information from them
+// only the DC coefficients of the JPEG are evaluated at this scale, no frame sized buffer is needed
+class FrameAnalyzer {
+private:
+    const uint8_t *input = NULL; // JPEG currently being decoded
+    uint16_t width = 0;          // width of the decoded (scaled) image
+    uint16_t height = 0;         // height of the decoded (scaled) image
+
+    uint32_t cellSum[FRAME_GRID_CELLS];
+    uint16_t cellCount[FRAME_GRID_CELLS];
+    uint32_t histogram[FRAME_HISTOGRAM_BINS];
+    uint32_t pixelCount = 0;
+    uint8_t meanLuminance = 0;
+
+    uint8_t signature[FRAME_GRID_CELLS]; // luminance signature of the last analyzed frame
+    uint8_t reference[FRAME_GRID_CELLS]; // luminance signature of the last frame marked as reference
+    bool hasReference = false;
+
+    friend size_t frameAnalyzerRead(void *arg, size_t index, uint8_t *buf, size_t len);
+    friend bool frameAnalyzerWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data);
+
+public:
+    bool analyze(camera_fb_t *fb);
+    uint8_t difference();
+    uint8_t mean();
+    uint8_t saturation();
+
+    void setReference();
+    void clearReference();
+};
+
+size_t frameAnalyzerRead(void *arg, size_t index, uint8_t *buf, size_t len);
+bool frameAnalyzerWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data);
+
+#endif
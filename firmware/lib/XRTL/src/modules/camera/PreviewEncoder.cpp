@@ -0,0 +1,142 @@
+#include "PreviewEncoder.h"
+
+PreviewEncoder::~PreviewEncoder() {
+    release();
+    if (image) free(image);
+}
+
+/**
+ * @brief reader callback of the JPEG decoder, hands out the compressed frame
+ * @param arg pointer to the PreviewEncoder
+ * @param index position in the JPEG data
+ * @param buf copy the data here, NULL if the data is supposed to be skipped
+ * @param len number of bytes requested
+ * @returns number of bytes delivered
+ */
+size_t previewEncoderRead(void *arg, size_t index, uint8_t *buf, size_t len) {
+    PreviewEncoder *encoder = (PreviewEncoder *)arg;
+    if (buf) {
+        memcpy(buf, encoder->input + index, len);
+    }
+    return len;
+}
+
+/**
+ * @brief writer callback of the JPEG decoder, copies the decoded blocks into the image buffer
+ * @param arg pointer to the PreviewEncoder
+ * @param x horizontal position of the block
+ * @param y vertical position of the block
+ * @param w width of the block
+ * @param h height of the block
+ * @param data RGB888 data of the block, NULL when decoding starts or ends
+ * @returns true if decoding should continue
+ */
+bool previewEncoderWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+    PreviewEncoder *encoder = (PreviewEncoder *)arg;
+    if (!data) {
+        if (x != 0 || y != 0) return true; // decoding finished
+
+        // decoding starts, dimensions of the scaled image are supplied
+        encoder->width = w;
+        encoder->height = h;
+        size_t requiredSize = (size_t)w * h * (encoder->gray ? 1 : 3);
+        if (requiredSize <= encoder->imageSize) return true;
+
+        if (encoder->image) free(encoder->image);
+        encoder->image = (uint8_t *)(psramFound() ? ps_malloc(requiredSize) : malloc(requiredSize));
+        encoder->imageSize = encoder->image ? requiredSize : 0;
+        return (encoder->image != NULL);
+    }
+
+    if (encoder->gray) {
+        for (uint16_t iy = y; iy < y + h; iy++) {
+            uint8_t *out = encoder->image + (size_t)iy * encoder->width + x;
+            for (uint16_t ix = 0; ix < w; ix++) {
+                out[ix] = (77 * data[0] + 150 * data[1] + 29 * data[2]) >> 8;
+                data += 3;
+            }
+        }
+        return true;
+    }
+
+    for (uint16_t iy = y; iy < y + h; iy++) {
+        uint8_t *out = encoder->image + ((size_t)iy * encoder->width + x) * 3;
+        for (uint16_t ix = 0; ix < w; ix++) {
+            out[0] = data[2];
+            out[1] = data[1];
+            out[2] = data[0];
+            out += 3;
+            data += 3;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief downscale a JPEG frame and encode the result as new JPEG
+ * @param fb frame buffer holding a JPEG image
+ * @param scale downscaling factor: 2, 4 or 8
+ * @param grayscale encode a single channel image, reduces size and encoding time
+ * @param quality JPEG quality of the preview (1-100, higher is better)
+ * @returns true if the preview is available via data() and length()
+ * @note call release() once the preview has been sent
+ */
+bool PreviewEncoder::encode(camera_fb_t *fb, uint8_t scale, bool grayscale, uint8_t quality) {
+    release();
+    if (!fb || fb->format != PIXFORMAT_JPEG) return false;
+
+    jpg_scale_t jpegScale;
+    switch (scale) {
+    case 2: {
+        jpegScale = JPG_SCALE_2X;
+        break;
+    }
+    case 4: {
+        jpegScale = JPG_SCALE_4X;
+        break;
+    }
+    default: {
+        jpegScale = JPG_SCALE_8X;
+        break;
+    }
+    }
+
+    gray = grayscale;
+    input = fb->buf;
+    esp_err_t decodeStatus = esp_jpg_decode(fb->len, jpegScale, previewEncoderRead, previewEncoderWrite, this);
+    input = NULL;
+    if (decodeStatus != ESP_OK) return false;
+
+    pixformat_t format = gray ? PIXFORMAT_GRAYSCALE : PIXFORMAT_RGB888;
+    size_t imageLength = (size_t)width * height * (gray ? 1 : 3);
+    if (!fmt2jpg(image, imageLength, width, height, format, quality, &jpeg, &jpegLength)) {
+        jpeg = NULL;
+        jpegLength = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @returns pointer to the encoded preview
+ */
+uint8_t *PreviewEncoder::data() {
+    return jpeg;
+}
+
+/**
+ * @returns size of the encoded preview in bytes
+ */
+size_t PreviewEncoder::length() {
+    return jpegLength;
+}
+
+/**
+ * @brief free the memory of the encoded preview
+ */
+void PreviewEncoder::release() {
+    if (jpeg) free(jpeg);
+    jpeg = NULL;
+    jpegLength = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef PREVIEWENCODER_H
+#define PREVIEWENCODER_H
+
+#include "common/XRTLfunctions.h"
+#include <esp_camera.h>
+#include <esp_jpg_decode.h>
+#include <img_converters.h>
+
+// create a downscaled JPEG from a full resolution JPEG frame
+// the JPEG decoder scales by averaging (at 1/8 only the DC coefficients are used), which bins neighboring pixels
+class PreviewEncoder {
+private:
+    const uint8_t *input = NULL; // JPEG currently being decoded
+    uint8_t *image = NULL;       // decoded and downscaled image, RGB888 (stored in BGR order like the camera driver) or grayscale
+    size_t imageSize = 0;        // allocated size of image in bytes
+    uint16_t width = 0;
+    uint16_t height = 0;
+    bool gray = false;
+
+    uint8_t *jpeg = NULL; // encoded preview, allocated by the encoder
+    size_t jpegLength = 0;
+
+    friend size_t previewEncoderRead(void *arg, size_t index, uint8_t *buf, size_t len);
+    friend bool previewEncoderWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data);
+
+public:
+    ~PreviewEncoder();
+
+    bool encode(camera_fb_t *fb, uint8_t scale, bool grayscale, uint8_t quality);
+    uint8_t *data();
+    size_t length();
+    void release();
+};
+
+size_t previewEncoderRead(void *arg, size_t index, uint8_t *buf, size_t len);
+bool previewEncoderWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data);
+
+#endif
@@ -0,0 +1,232 @@
+#include "ControllerModule.h"
+
+ControllerModule::ControllerModule(String moduleName) {
+    id = moduleName;
+
+    parameters.setKey(id);
+    parameters.add(type, "type");
+    parameters.add(inputId, "input", "String");
+    parameters.add(outputId, "output", "String");
+    parameters.add(setpoint, "setpoint", "float");
+    parameters.add(kp, "kp", "float");
+    parameters.add(ki, "ki", "1/s");
+    parameters.add(kd, "kd", "s");
+    parameters.add(minOutput, "minOutput", "float");
+    parameters.add(maxOutput, "maxOutput", "float");
+    parameters.add(period, "period", "ms");
+    parameters.add(active, "active", "y/n");
+}
+
+moduleType ControllerModule::getType() {
+    return type;
+}
+
+void ControllerModule::setup() {
+    period = max(period, (uint32_t)1);
+    pid.setGains(kp, ki, kd);
+    pid.setLimits(minOutput, maxOutput);
+
+    if (!connect()) {
+        active = false;
+        debug("controller deactivated");
+        return;
+    }
+
+    startPending = active; // the input might be set up after this module
+}
+
+/**
+ * @brief locate input and output module
+ * @returns true if both modules are present and of a suitable type
+ */
+bool ControllerModule::connect() {
+    input = NULL;
+    output = NULL;
+    servo = NULL;
+
+    XRTLmodule *candidate = findModule(inputId);
+    if (candidate && candidate->getType() == xrtl_input) {
+        input = static_cast<InputModule *>(candidate);
+    } else {
+        debug("WARNING: <%s> is no input module", inputId.c_str());
+    }
+
+    candidate = findModule(outputId);
+    if (candidate && candidate->getType() == xrtl_output) {
+        output = static_cast<OutputModule *>(candidate);
+    } else if (candidate && candidate->getType() == xrtl_servo) {
+        servo = static_cast<ServoModule *>(candidate);
+    } else {
+        debug("WARNING: <%s> is neither output nor servo module", outputId.c_str());
+    }
+
+    return (input && (output || servo));
+}
+
+/**
+ * @brief start controlling, the integral starts at the lower output limit
+ */
+void ControllerModule::start() {
+    if (!input || (!output && !servo)) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] input or output missing, check settings";
+        sendError(hardware_failure, errmsg);
+        active = false;
+        return;
+    }
+    if (!input->initialized()) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] input <";
+        errmsg += inputId;
+        errmsg += "> deactivated, check its pin";
+        sendError(hardware_failure, errmsg);
+        active = false;
+        return;
+    }
+
+    pid.reset(minOutput);
+    maxJitter = 0;
+    missed = 0;
+    lastUpdate = 0;
+    nextUpdate = esp_timer_get_time();
+    active = true;
+    debug("controlling <%s> by <%s> every %d ms", outputId.c_str(), inputId.c_str(), period);
+}
+
+void ControllerModule::loop() {
+    if (startPending) {
+        startPending = false;
+        start();
+    }
+    if (!active) return;
+
+    int64_t now = esp_timer_get_time();
+    if (now < nextUpdate) return;
+
+    update(now);
+}
+
+/**
+ * @brief run a single control step and schedule the next one
+ * @param now current time; µs
+ * @note the schedule is kept in multiples of the period, delays do not accumulate
+ */
+void ControllerModule::update(int64_t now) {
+    lastJitter = now - nextUpdate;
+    maxJitter = max(maxJitter, lastJitter);
+
+    double dt = (lastUpdate == 0) ? 0.0 : (now - lastUpdate) / 1000000.0;
+    lastUpdate = now;
+
+    measurement = input->read();
+    controlOutput = pid.update(setpoint, measurement, dt);
+    drive(controlOutput);
+
+    int64_t periodMicroSeconds = 1000 * (int64_t)period;
+    nextUpdate += periodMicroSeconds;
+    if (nextUpdate <= now) { // blocked for more than a period, skip the missed updates
+        int64_t behind = (now - nextUpdate) / periodMicroSeconds + 1;
+        missed += behind;
+        nextUpdate += behind * periodMicroSeconds;
+    }
+}
+
+/**
+ * @brief pass the controller output on to the actuator
+ * @param value output within minOutput and maxOutput
+ */
+void ControllerModule::drive(double value) {
+    if (output) {
+        output->write((uint8_t)constrain(lround(value), 0L, 255L));
+    } else if (servo) {
+        servo->write(value);
+    }
+}
+
+void ControllerModule::stop() {
+    startPending = false;
+    if (!active) return;
+
+    active = false;
+    controlOutput = minOutput;
+    drive(minOutput);
+    debug("controller stopped, output set to %f", minOutput);
+}
+
+void ControllerModule::saveSettings(JsonObject &settings) {
+    parameters.save(settings);
+}
+
+void ControllerModule::loadSettings(JsonObject &settings) {
+    parameters.load(settings);
+    if (debugging && *debugging) parameters.print();
+}
+
+void ControllerModule::setViaSerial() {
+    parameters.setViaSerial();
+}
+
+bool ControllerModule::getStatus(JsonObject &status) {
+    status["active"] = active;
+    status["setpoint"] = setpoint;
+    status["input"] = measurement;
+    status["output"] = controlOutput;
+    status["saturated"] = pid.isSaturated();
+    status["kp"] = kp;
+    status["ki"] = ki;
+    status["kd"] = kd;
+    status["period"] = period;
+    status["jitter"] = lastJitter;
+    status["maxJitter"] = maxJitter;
+    status["missed"] = missed;
+
+    return true;
+}
+
+void ControllerModule::handleCommand(String &controlId, JsonObject &command) {
+    if (!isModule(controlId) && controlId != "*") return;
+
+    bool temp = false;
+    if (getValue<bool>("getStatus", command, temp) && temp) {
+        sendStatus();
+    }
+
+    bool changed = getValue<double>("setpoint", command, setpoint);
+
+    bool gainsChanged = getValue<double>("kp", command, kp);
+    gainsChanged |= getValue<double>("ki", command, ki);
+    gainsChanged |= getValue<double>("kd", command, kd);
+    if (gainsChanged) pid.setGains(kp, ki, kd);
+
+    bool limitsChanged = getValue<double>("minOutput", command, minOutput);
+    limitsChanged |= getValue<double>("maxOutput", command, maxOutput);
+    if (limitsChanged) pid.setLimits(minOutput, maxOutput);
+
+    if (getAndConstrainValue<uint32_t>("period", command, period, 1, 3600000)) {
+        changed = true;
+    }
+
+    if (getValue<bool>("active", command, temp)) {
+        if (temp && !active) {
+            start();
+        } else if (!temp) {
+            stop();
+        }
+        changed = true;
+    }
+
+    if (changed || gainsChanged || limitsChanged) sendStatus();
+}
+
+void ControllerModule::handleInternal(internalEvent eventId, String &sourceId) {
+    switch (eventId) {
+    case socket_disconnected: { // outputs power down on disconnect, the controller must not switch them on again
+        if (!active) return;
+        stop();
+        debug("controller stopped due to disconnect event");
+        return;
+    }
+    }
+}
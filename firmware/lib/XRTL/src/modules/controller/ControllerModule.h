@@ -0,0 +1,65 @@
+#ifndef CONTROLLERMODULE_H
+#define CONTROLLERMODULE_H
+
+#include "XRTLpid.h"
+#include "modules/input/InputModule.h"
+#include "modules/output/OutputModule.h"
+#include "modules/servo/ServoModule.h"
+
+// closed loop control of a local output or servo by the value of a local input
+// the loop runs on the hardware at a fixed period, no round trip to the server is involved
+class ControllerModule : public XRTLmodule {
+private:
+    String inputId = "";  // controlId of the InputModule delivering the measurement
+    String outputId = ""; // controlId of the OutputModule (pwm: 0-255) or ServoModule (value range) to drive
+
+    double setpoint = 0.0; // converted value of the input
+    double kp = 1.0;
+    double ki = 0.0; // 1/s
+    double kd = 0.0; // s
+    double minOutput = 0.0;
+    double maxOutput = 255.0;
+    uint32_t period = 100; // time between two updates in ms
+    bool active = false;   // control immediately after start
+    bool startPending = false; // active setting is applied by the first loop, once all inputs ran their setup
+
+    XRTLpid pid;
+    InputModule *input = NULL;
+    OutputModule *output = NULL;
+    ServoModule *servo = NULL;
+
+    double measurement = 0.0;
+    double controlOutput = 0.0;
+
+    // timing
+    int64_t nextUpdate = 0;
+    int64_t lastUpdate = 0;
+    uint32_t lastJitter = 0; // delay of the last update; µs
+    uint32_t maxJitter = 0;  // µs
+    uint32_t missed = 0;     // periods skipped because the loop was blocked
+
+    bool connect();
+    void update(int64_t now);
+    void drive(double value);
+
+public:
+    ControllerModule(String moduleName);
+    moduleType type = xrtl_controller;
+    moduleType getType();
+
+    void setup();
+    void loop();
+    void stop();
+
+    void start();
+
+    void saveSettings(JsonObject &settings);
+    void loadSettings(JsonObject &settings);
+    void setViaSerial();
+    bool getStatus(JsonObject &status);
+
+    void handleCommand(String &controlId, JsonObject &command);
+    void handleInternal(internalEvent eventId, String &sourceId);
+};
+
+#endif
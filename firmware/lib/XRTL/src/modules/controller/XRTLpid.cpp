@@ -0,0 +1,83 @@
+#include "XRTLpid.h"
+
+/**
+ * @brief set the gains of the controller
+ * @param proportional output per unit of error
+ * @param integralGain output per unit of error and second
+ * @param derivativeGain output per unit of error per second
+ * @note can be called while running, the output does not jump due to the integral
+ */
+void XRTLpid::setGains(double proportional, double integralGain, double derivativeGain) {
+    kp = proportional;
+    ki = integralGain;
+    kd = derivativeGain;
+}
+
+/**
+ * @brief limit the output to a range
+ * @param lower lowest output
+ * @param upper highest output
+ */
+void XRTLpid::setLimits(double lower, double upper) {
+    minOutput = min(lower, upper);
+    maxOutput = max(lower, upper);
+    integral = constrain(integral, minOutput, maxOutput);
+}
+
+/**
+ * @brief restart the controller
+ * @param output output to continue with, the integral is preset to it for a bumpless start
+ */
+void XRTLpid::reset(double output) {
+    integral = constrain(output, minOutput, maxOutput);
+    derivative = 0.0;
+    initialized = false;
+    saturated = false;
+}
+
+/**
+ * @brief calculate the next output
+ * @param setpoint target value of the measurement
+ * @param measurement current value of the controlled quantity
+ * @param dt time since the last update in s
+ * @returns output constrained to the limits
+ */
+double XRTLpid::update(double setpoint, double measurement, double dt) {
+    double error = setpoint - measurement;
+
+    if (!initialized || dt <= 0.0) {
+        lastMeasurement = measurement;
+        derivative = 0.0;
+        initialized = true;
+        dt = 0.0;
+    }
+
+    // derivative on measurement, low pass filtered
+    if (dt > 0.0 && kd != 0.0) {
+        double rate = (measurement - lastMeasurement) / dt;
+        double filterTime = (kp != 0.0) ? fabs(kd / kp) / PID_DERIVATIVE_FILTER : 0.0;
+        derivative += (rate - derivative) * dt / (dt + filterTime);
+    }
+    lastMeasurement = measurement;
+
+    // conditional integration: only integrate if the result is not saturated in the direction of the integration
+    double step = ki * error * dt;
+    double candidate = integral + step;
+    double output = kp * error + candidate - kd * derivative;
+    if ((output > maxOutput && step > 0.0) || (output < minOutput && step < 0.0)) {
+        output = kp * error + integral - kd * derivative;
+    } else {
+        integral = candidate;
+    }
+    integral = constrain(integral, minOutput, maxOutput);
+
+    saturated = (output > maxOutput || output < minOutput);
+    return constrain(output, minOutput, maxOutput);
+}
+
+/**
+ * @returns true if the last output was limited
+ */
+bool XRTLpid::isSaturated() {
+    return saturated;
+}
@@ -0,0 +1,34 @@
+#ifndef XRTLPID_H
+#define XRTLPID_H
+
+#include "common/XRTLfunctions.h"
+
+#define PID_DERIVATIVE_FILTER 10.0 // the derivative is low pass filtered with a time constant of kd / kp / PID_DERIVATIVE_FILTER
+
+// PID controller in parallel form with output limits
+// the integral is kept in output units, so gains can be changed without a bump in the output.
+// Anti-windup: the integral is frozen while the output is saturated and the error would drive it further.
+// The derivative acts on the measurement only, setpoint changes cause no kick.
+class XRTLpid {
+private:
+    double kp = 1.0;
+    double ki = 0.0; // 1/s
+    double kd = 0.0; // s
+    double minOutput = 0.0;
+    double maxOutput = 255.0;
+
+    double integral = 0.0;   // output units
+    double derivative = 0.0; // filtered rate of change of the measurement
+    double lastMeasurement = 0.0;
+    bool initialized = false;
+    bool saturated = false;
+
+public:
+    void setGains(double proportional, double integralGain, double derivativeGain);
+    void setLimits(double lower, double upper);
+    void reset(double output);
+    double update(double setpoint, double measurement, double dt);
+    bool isSaturated();
+};
+
+#endif
@@ -10,18 +10,34 @@ InputModule::InputModule(String moduleName) {
     parameters.add(pin, "pin", "int");
     parameters.add(type, "type");
     parameters.add(averageTime, "averageTime", "ms");
+    parameters.add(filterType, "filter", "0: average, 1: exponential, 2: median, 3: biquad");
+    parameters.add(continuous, "continuous", "y/n");
+    parameters.addDependent(sampleRate, "sampleRate", "Hz", "continuous", true);
+    parameters.add(statisticsMode, "statistics", "y/n");
+    parameters.add(blockMode, "blockMode", "y/n");
+    parameters.addDependent(rawBlocks, "rawBlocks", "y/n", "blockMode", true);
+    parameters.addDependent(blockRate, "blockRate", "Hz", "blockMode", true);
     parameters.add(rangeChecking, "rangeChecking", "");
     parameters.addDependent(isBinary, "isBinary", "y/n", "rangeChecking", true);
     parameters.addDependent(loBound, "loBound", "float", "rangeChecking", true);
     parameters.addDependent(hiBound, "hiBound", "float", "rangeChecking", true);
     parameters.addDependent(deadMicroSeconds, "deadMicroSeconds", "µs", "rangeChecking", true);
+    parameters.addDependent(edgeInterrupt, "edgeInterrupt", "y/n", "isBinary", true);
 }
 
 InputModule::~InputModule() {
-    for (int i = 0; i < conversionCount; i++) {
-        delete conversion[i];
-    }
+    delete lockIn;
+    delete spectrum;
+    delete statistics;
+    delete scope;
+    delete edges;
     delete input;
+    free(blockSamples);
+    free(blockData);
+}
+
+moduleType InputModule::getType() {
+    return type;
 }
 
 void InputModule::setup() {
@@ -60,8 +76,22 @@ void InputModule::setup() {
     }
 
     input = new XRTLinput; 
-    input->attach(pin);
+    input->setFilter(filterType);
     input->averageTime(averageTime);          // in ms
+    if (!continuous) {
+        input->attach(pin);
+    } else if (!input->attach(pin, sampleRate)) {
+        debug("WARNING: continuous sampling unavailable (ADC1 pin and free I2S0 required), polling instead");
+        if (i2sOwner()) {
+            String errmsg = "[";
+            errmsg += id;
+            errmsg += "] continuous sampling unavailable: I2S0 used by ";
+            errmsg += i2sOwner();
+            sendError(hardware_failure, errmsg);
+        }
+    } else {
+        debug("sampling continuously at %d Hz", sampleRate);
+    }
 
     if (input->readMilliVolts() >= hiBound) { // initialize lastState
         lastState = true;
@@ -69,6 +99,14 @@ void InputModule::setup() {
         lastState = false;
     }
 
+    if (rangeChecking && isBinary && edgeInterrupt) {
+        edges = new XRTLedges;
+        edges->begin(pin);
+        lastState = digitalRead(pin);
+        heldEdge = false;
+        debug("detecting edges via interrupt");
+    }
+
     next = esp_timer_get_time();      // start streaming immediately
     nextCheck = esp_timer_get_time(); // check immediately
     debug("input initialized");
@@ -78,34 +116,31 @@ void InputModule::loop() {
     if (!input) return;
     
     input->loop();
+    if (scope && scope->state() == scope_complete) sendScope();
+    if (spectrum) {
+        if (spectrum->complete()) {
+            sendSpectrum();
+        } else if (!spectrum->active() && esp_timer_get_time() >= nextSpectrum) {
+            spectrum->start();
+            nextSpectrum = esp_timer_get_time() + 1000000.0 / spectrumRate;
+        }
+    }
+    if (lockIn && esp_timer_get_time() >= nextLockIn) sendLockIn();
 
     int64_t now = esp_timer_get_time();
     value = input->readMilliVolts();
 
-    // apply conversion if defined
-    for (int i = 0; i < conversionCount; i++) {
-        conversion[i]->convert(value);
+    conversions.apply(value);
+
+    if (edges) {
+        checkEdges();
+    } else if (rangeChecking && now >= nextCheck) {
+        checkRange(now);
     }
 
-    if (rangeChecking && now >= nextCheck) {
-        if (value >= hiBound) {
-            if (isBinary && lastState) { // no trigger if state = lastState
-            } else {
-                debug("high input");
-                lastState = true;
-                nextCheck = now + deadMicroSeconds;
-                notify(input_trigger_high);
-            }
-        }
-        if (value < loBound) {
-            if (isBinary && !lastState) {// no trigger if state = lastState
-            } else {
-                debug("low input");
-                lastState = false;
-                nextCheck = now + deadMicroSeconds;
-                notify(input_trigger_low);
-            }
-        }
+    if (isStreaming && blockMode) {
+        if (input->captureComplete()) sendBlock();
+        return;
     }
 
     if (!isStreaming || now < next) return;
@@ -113,6 +148,11 @@ void InputModule::loop() {
     // debug("reporting voltage: %f mV", value);
     next = now + intervalMicroSeconds;
 
+    if (statistics) {
+        sendStatistics();
+        return;
+    }
+
     DynamicJsonDocument doc(512);
     JsonArray event = doc.to<JsonArray>();
 
@@ -134,40 +174,110 @@ void InputModule::loop() {
     sendEvent(event);
 }
 
+/**
+ * @returns current converted value of the input
+ * @note updated once per loop
+ */
+double InputModule::read() {
+    return value;
+}
+
+/**
+ * @returns false if the pin failed the setup and the input is deactivated
+ */
+bool InputModule::initialized() {
+    return (input != NULL);
+}
+
+/**
+ * @brief compare the converted value against the bounds and notify on triggers
+ * @param now current time; µs
+ */
+void InputModule::checkRange(int64_t now) {
+    if (value >= hiBound) {
+        if (isBinary && lastState) { // no trigger if state = lastState
+        } else {
+            debug("high input");
+            lastState = true;
+            nextCheck = now + deadMicroSeconds;
+            notify(input_trigger_high);
+        }
+    }
+    if (value < loBound) {
+        if (isBinary && !lastState) {// no trigger if state = lastState
+        } else {
+            debug("low input");
+            lastState = false;
+            nextCheck = now + deadMicroSeconds;
+            notify(input_trigger_low);
+        }
+    }
+}
+
+/**
+ * @brief drain the edges recorded by the interrupt and notify on triggers
+ * @note the dead time is measured from the timestamp of the edge, not from the time it is processed
+ */
+void InputModule::checkEdges() {
+    edge_t edge;
+    while (edges->pop(edge)) {
+        if (heldEdge && edge.time >= nextCheck) { // the dead time ended before this edge
+            heldEdge = false;
+            triggerEdge(heldLevel, nextCheck);
+        }
+        if (edge.time < nextCheck) {
+            heldEdge = true;
+            heldLevel = edge.level;
+            continue;
+        }
+        triggerEdge(edge.level, edge.time);
+    }
+
+    // the pin may have changed back and forth within the dead time: report the level it settled at
+    if (heldEdge && esp_timer_get_time() >= nextCheck) {
+        heldEdge = false;
+        triggerEdge(heldLevel, nextCheck);
+    }
+}
+
+/**
+ * @brief notify about a new level and start the dead time
+ * @param level level of the pin after the edge
+ * @param time time of the edge, or the end of the dead time for a held edge; µs
+ * @note no trigger if the level equals the last reported state
+ */
+void InputModule::triggerEdge(bool level, int64_t time) {
+    if (level == lastState) return;
+
+    lastState = level;
+    nextCheck = time + deadMicroSeconds;
+    notify(lastState ? input_trigger_high : input_trigger_low);
+
+    lastLatency = esp_timer_get_time() - time;
+    maxLatency = max(maxLatency, lastLatency);
+    debug("%s edge, latency: %d µs", lastState ? "rising" : "falling", lastLatency);
+}
+
 void InputModule::stop() {
     stopStreaming();
+    disarmScope();
+    stopSpectrum();
+    stopLockIn();
 }
 
 void InputModule::saveSettings(JsonObject &settings) {
     JsonObject subSettings;
     parameters.save(settings, subSettings);
 
-    // conversion settings
-    if (conversionCount == 0) return;
-
-    JsonArray conversionSettings = subSettings.createNestedArray("conversions");
-    for (int i = 0; i < conversionCount; i++) {
-        JsonObject saveConversionConfig = conversionSettings.createNestedObject();
-        conversion[i]->saveSettings(saveConversionConfig);
-    }
+    conversions.save(subSettings);
 }
 
 void InputModule::loadSettings(JsonObject &settings) {
     JsonObject subSettings;
     parameters.load(settings, subSettings);
 
-    // load conversions
-    JsonArray loadedConversion = subSettings["conversions"];
-    if (!loadedConversion.isNull()) {
-        for (JsonVariant value : loadedConversion) { // iterate over all objects within loadedConversion
-            JsonObject conversionSettings = value.as<JsonObject>();
-            auto typeField = conversionSettings["type"];
-            conversion_t convType = loadValue<conversion_t>("type", conversionSettings, offset);
-            addConversion(convType);
-            conversion[conversionCount - 1]->loadSettings(conversionSettings, *debugging);
-            // if (debugging) Serial.println("");
-        }
-    }
+    conversions.load(subSettings, debugging && *debugging);
+    compileConversions();
 
     if (debugging && *debugging) parameters.print();
 }
@@ -177,75 +287,6 @@ void InputModule::setViaSerial() {
     }
 }
 
-bool InputModule::conversionDialog() {
-    Serial.println("");
-    Serial.println(centerString("current conversions", 55, ' '));
-    Serial.println("");
-
-    for (int i = 0; i < conversionCount; i++) {
-        Serial.printf("%d: %s\n", i, conversionName[conversion[i]->getType()]);
-    }
-
-    Serial.println("");
-    Serial.println("a: add conversion");
-    Serial.println("d: delete conversion");
-    Serial.println("s: swap conversions");
-    Serial.println("r: return");
-
-    Serial.println("");
-    String choice = serialInput("send single letter or number to edit conversion: ");
-    uint8_t choiceNum = choice.toInt();
-
-    if (choice == "r") {
-        return false;
-    } else if (choice == "a") {
-        Serial.println(centerString("conversions available", 55, ' ').c_str());
-        for (int i = 0; i < 6; i++) {
-            Serial.printf("%d: %s\n", i, conversionName[i]);
-        }
-        Serial.println("");
-
-        conversion_t type = (conversion_t)serialInput("send number to specify type: ").toInt();
-        addConversion(type);
-        Serial.printf("conversionCount: %d\n", conversionCount);
-        conversion[conversionCount - 1]->setViaSerial();
-    } else if (choice == "d") {
-        Serial.println("");
-        uint8_t deleteChoice = serialInput("send number to delete conversion: ").toInt();
-
-        if (deleteChoice >= conversionCount) return true;
-
-        delete conversion[deleteChoice];
-
-        for (int i = deleteChoice; i < conversionCount; i++) {
-            conversion[i] = conversion[i + 1];
-        }
-        conversion[conversionCount--] = NULL;
-    } else if (choice == "s") {
-        Serial.println("");
-        Serial.println("send the numbers of two conversions to swap");
-
-        String choiceOne = serialInput("first conversion: ");
-        if (choiceOne == "r") return true;
-
-        String choiceTwo = serialInput("second conversion: ");
-        if (choiceTwo == "r") return true;
-
-        uint8_t choiceOneNum = choiceOne.toInt();
-        uint8_t choiceTwoNum = choiceTwo.toInt();
-
-        if (choiceOneNum < conversionCount || choiceTwoNum < conversionCount || choiceOneNum != choiceTwoNum) {
-            InputConverter *tmp = conversion[choiceOneNum];
-            conversion[choiceOneNum] = conversion[choiceTwoNum];
-            conversion[choiceTwoNum] = tmp;
-        }
-    } else if (choiceNum < conversionCount) {
-        conversion[choiceNum]->setViaSerial();
-    }
-
-    return true;
-}
-
 bool InputModule::dialog() {
     highlightString(id.c_str(), '-');
 
@@ -262,8 +303,9 @@ bool InputModule::dialog() {
     else if (choice == "b")
         parameters.setViaSerial();
     else if (choice == "m") {
-        while (conversionDialog()) {
+        while (conversions.dialog()) {
         }
+        compileConversions();
     }
 
     return true;
@@ -279,8 +321,27 @@ bool InputModule::getStatus(JsonObject &status) {
     }
 
     status["averageTime"] = averageTime;
+    status["filter"] = filterName[filterType];
+    status["sampleRate"] = input->sampleRate();
     status["updateTime"] = intervalMicroSeconds / 1000;
     status["stream"] = isStreaming;
+    status["statistics"] = statisticsMode;
+    status["blockMode"] = blockMode;
+    if (edges) {
+        status["edgeLatency"] = lastLatency;
+        status["maxEdgeLatency"] = maxLatency;
+        status["shortestPulse"] = edges->shortestPulse();
+        status["missedPulses"] = edges->missed() + edges->dropped();
+    }
+    status["spectrum"] = (spectrum != NULL);
+    if (spectrum) status["spectrumTime"] = spectrumTime;
+    status["lockIn"] = (lockIn != NULL);
+    if (lockIn) status["lockInFrequency"] = lockInFrequency;
+    status["scope"] = scope ? scopeStateName[scope->state()] : scopeStateName[scope_idle];
+    if (blockMode) {
+        status["blockRate"] = blockRate;
+        status["blockLength"] = blockLength;
+    }
 
     if (isBinary) {
         status["input"] = lastState;
@@ -296,6 +357,8 @@ void InputModule::startStreaming() {
         debug("stream already active");
         return;
     }
+    if (blockMode && !startBlocks()) return;
+    if (!blockMode && statisticsMode) startStatistics();
     next = esp_timer_get_time(); // immediately deliver first value
     isStreaming = true;
     sendStatus();
@@ -307,11 +370,462 @@ void InputModule::stopStreaming() {
         debug("stream already inactive");
         return;
     }
+    stopBlocks();
+    stopStatistics();
     isStreaming = false;
     sendStatus();
     debug("stopped streaming values");
 }
 
+/**
+ * @brief allocate the block buffers and start capturing the first block
+ * @returns true if block streaming started
+ * @note the block length is derived from the current sample period and blockRate
+ */
+bool InputModule::startBlocks() {
+    if (!input) return false;
+
+    double samplesPerSecond = 1000000.0 / input->samplePeriod();
+    blockLength = constrain((uint32_t)(samplesPerSecond / max(blockRate, (uint16_t)1)), (uint32_t)1, (uint32_t)INPUT_BLOCK_MAX);
+
+    free(blockSamples);
+    free(blockData);
+    blockSamples = (uint16_t *)malloc(blockLength * sizeof(uint16_t));
+    blockData = (uint8_t *)malloc(blockLength * sizeof(float));
+    if (!blockSamples || !blockData) {
+        stopBlocks();
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate block buffer";
+        sendError(hardware_failure, errmsg);
+        return false;
+    }
+
+    input->startCapture(blockSamples, blockLength);
+    debug("streaming blocks of %d samples", blockLength);
+    return true;
+}
+
+/**
+ * @brief stop capturing and release the block buffers
+ */
+void InputModule::stopBlocks() {
+    if (input) input->stopCapture();
+    free(blockSamples);
+    free(blockData);
+    blockSamples = NULL;
+    blockData = NULL;
+    blockLength = 0;
+}
+
+/**
+ * @brief send the captured block as binary attachment and start capturing the next one
+ * @note float32: converted values, int16: raw voltage in mV. Sample i was taken at time + i * period (µs, esp_timer)
+ */
+void InputModule::sendBlock() {
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "block";
+    payload["format"] = rawBlocks ? "int16" : "float32";
+    payload["count"] = blockLength;
+    payload["time"] = input->captureStart();
+    payload["period"] = input->samplePeriod();
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    size_t length = packSamples(blockSamples, blockLength, blockData);
+    input->startCapture(blockSamples, blockLength);
+    sendBinary(leadFrame, blockData, length);
+}
+
+/**
+ * @brief convert captured samples into the binary format used for blocks and scope records
+ * @param samples captured samples in mV (Q4)
+ * @param count number of samples
+ * @param target receives the packed samples, must hold count * 4 bytes
+ * @returns size of the packed samples in bytes
+ * @note float32: converted values, int16: raw voltage in mV (rawBlocks)
+ */
+size_t InputModule::packSamples(uint16_t *samples, uint32_t count, uint8_t *target) {
+    if (rawBlocks) {
+        int16_t *packed = (int16_t *)target;
+        for (uint32_t i = 0; i < count; i++) {
+            packed[i] = (samples[i] + (1 << (FILTER_FRACTION - 1))) >> FILTER_FRACTION;
+        }
+        return count * sizeof(int16_t);
+    }
+
+    float *packed = (float *)target;
+    for (uint32_t i = 0; i < count; i++) {
+        double sample = ((double)samples[i]) / (1 << FILTER_FRACTION);
+        conversions.apply(sample);
+        packed[i] = sample;
+    }
+    return count * sizeof(float);
+}
+
+/**
+ * @brief start collecting the statistics of the raw samples
+ * @note the first window ends with the next streaming interval
+ */
+void InputModule::startStatistics() {
+    if (!input) return;
+
+    if (!statistics) statistics = new XRTLstatistics;
+    statistics->reset(esp_timer_get_time());
+    input->setStatistics(statistics);
+    next = esp_timer_get_time() + intervalMicroSeconds; // a window covers the full interval
+}
+
+/**
+ * @brief stop collecting statistics
+ */
+void InputModule::stopStatistics() {
+    if (!statistics) return;
+
+    if (input) input->setStatistics(NULL);
+    delete statistics;
+    statistics = NULL;
+}
+
+/**
+ * @brief send the statistics of the past interval and start a new window
+ * @note the statistics are taken of the raw voltage and passed through the conversions afterwards:
+ * mean, min and max are converted directly, the deviation is scaled by the slope of the conversions at the mean.
+ * This is exact for affine conversions and a first order approximation otherwise.
+ */
+void InputModule::sendStatistics() {
+    int64_t now = esp_timer_get_time();
+    uint32_t count = statistics->samples();
+    int64_t start = statistics->start();
+    double mean = statistics->average();
+    double variance = statistics->variance();
+    double deviation = statistics->deviation();
+    double lowest = statistics->lowest();
+    double highest = statistics->highest();
+    statistics->reset(now);
+
+    if (count == 0) return;
+
+    double upper = mean + 0.5;
+    double lower = mean - 0.5;
+    conversions.apply(upper);
+    conversions.apply(lower);
+    double slope = fabs(upper - lower); // per mV
+
+    conversions.apply(mean);
+    conversions.apply(lowest);
+    conversions.apply(highest);
+    if (lowest > highest) { // decreasing conversions, e.g. thermistors
+        double tmp = lowest;
+        lowest = highest;
+        highest = tmp;
+    }
+
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "statistics";
+
+    JsonObject data = payload.createNestedObject("data");
+    data["time"] = start;
+    data["duration"] = now - start;
+    data["count"] = count;
+    data["mean"] = mean;
+    data["min"] = lowest;
+    data["max"] = highest;
+    data["rms"] = sqrt(mean * mean + variance * slope * slope);
+    data["stddev"] = deviation * slope;
+
+    sendEvent(event);
+}
+
+/**
+ * @brief configure the scope with the current settings and wait for the trigger
+ * @note requires continuous sampling
+ */
+void InputModule::armScope() {
+    if (!input || !input->isContinuous()) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] scope requires continuous sampling";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    if (!scope) scope = new XRTLscope;
+    if (!scope->configure(scopeLength, scopePreTrigger, scopeLevel, scopeHysteresis, scopeRising)) {
+        disarmScope();
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate scope record";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    input->setScope(scope);
+    scope->arm();
+    debug("scope armed: %d samples, trigger at %d mV", scopeLength, scopeLevel);
+}
+
+/**
+ * @brief stop the scope and release the record
+ */
+void InputModule::disarmScope() {
+    if (!scope) return;
+
+    if (input) input->setScope(NULL);
+    delete scope;
+    scope = NULL;
+}
+
+/**
+ * @brief upload the completed scope record as a single binary event
+ * @note the trigger sample is located at index "pre" of the record, sample i was taken at time + (i - pre) * period (µs, esp_timer)
+ */
+void InputModule::sendScope() {
+    uint32_t length = scope->recordLength();
+    uint16_t *samples = (uint16_t *)malloc(length * sizeof(uint16_t));
+    uint8_t *packed = (uint8_t *)malloc(length * sizeof(float));
+    if (!samples || !packed) {
+        free(samples);
+        free(packed);
+        disarmScope();
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate memory for scope upload";
+        sendError(hardware_failure, errmsg);
+        sendStatus();
+        return;
+    }
+    scope->read(samples);
+
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "scope";
+    payload["format"] = rawBlocks ? "int16" : "float32";
+    payload["count"] = length;
+    payload["pre"] = scope->preTriggerLength();
+    payload["time"] = input->timestamp(scope->triggerSample());
+    payload["period"] = input->samplePeriod();
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    size_t size = packSamples(samples, length, packed);
+    sendBinary(leadFrame, packed, size);
+    free(samples);
+    free(packed);
+    debug("scope record sent");
+
+    if (scopeRepeat) {
+        scope->arm();
+        return;
+    }
+    disarmScope();
+    sendStatus();
+}
+
+/**
+ * @brief allocate the spectrum with the current settings and start recording
+ * @note requires continuous sampling
+ */
+void InputModule::startSpectrum() {
+    if (!input || !input->isContinuous()) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] spectrum requires continuous sampling";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    if (!spectrum) spectrum = new XRTLspectrum;
+    if (!spectrum->configure(spectrumLength)) {
+        stopSpectrum();
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate spectrum buffers";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+    spectrumLength = spectrum->transformLength();
+
+    input->setSpectrum(spectrum);
+    nextSpectrum = esp_timer_get_time(); // record the first spectrum immediately
+    debug("spectrum started: %d samples, %.0f Hz resolution", spectrumLength, input->sampleRate() / spectrumLength);
+}
+
+/**
+ * @brief stop the spectrum and release its buffers
+ */
+void InputModule::stopSpectrum() {
+    if (!spectrum) return;
+
+    if (input) input->setSpectrum(NULL);
+    delete spectrum;
+    spectrum = NULL;
+}
+
+/**
+ * @brief compute the recorded spectrum and send either all bins or the strongest peaks
+ * @note all bins: binary float32 amplitudes in mV, bin k is centered at k * resolution, bin 0 holds the mean.
+ * peaks: frequencies in Hz and amplitudes in mV sorted by amplitude. Amplitudes refer to the unconverted input voltage.
+ */
+void InputModule::sendSpectrum() {
+    int64_t start = esp_timer_get_time();
+    spectrum->compute();
+    spectrumTime = esp_timer_get_time() - start;
+    double resolution = input->sampleRate() / spectrum->transformLength(); // Hz per bin
+
+    DynamicJsonDocument doc(1024);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+
+    if (spectrumPeaks > 0) {
+        float bin[SPECTRUM_MAX_PEAKS];
+        float amplitude[SPECTRUM_MAX_PEAKS];
+        uint8_t found = spectrum->peaks(spectrumPeaks, bin, amplitude);
+
+        payload["type"] = "peaks";
+        JsonObject data = payload.createNestedObject("data");
+        data["time"] = input->timestamp(spectrum->firstSample());
+        data["mean"] = spectrum->average();
+        JsonArray frequencies = data.createNestedArray("frequency");
+        JsonArray amplitudes = data.createNestedArray("amplitude");
+        for (int i = 0; i < found; i++) {
+            frequencies.add(bin[i] * resolution);
+            amplitudes.add(amplitude[i]);
+        }
+
+        sendEvent(event);
+        return;
+    }
+
+    payload["type"] = "spectrum";
+    payload["format"] = "float32";
+    payload["count"] = spectrum->bins();
+    payload["resolution"] = resolution;
+    payload["time"] = input->timestamp(spectrum->firstSample());
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    sendBinary(leadFrame, (uint8_t *)spectrum->amplitudes(), spectrum->bins() * sizeof(float));
+}
+
+/**
+ * @brief start the reference and demodulate the input at its frequency
+ * @note requires continuous sampling. The reference output is set to a square wave with 50% duty cycle,
+ * a phase of 0° means the fundamental of the input peaks in the middle of the high phase of the reference.
+ */
+void InputModule::startLockIn() {
+    if (!input || !input->isContinuous()) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] lock-in requires continuous sampling";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    if (!lockIn) lockIn = new XRTLlockIn;
+    if (!lockIn->configure(lockInFrequency, input->sampleRate(), lockInTimeConstant)) {
+        stopLockIn();
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] reference frequency must be below half the sample rate";
+        sendError(out_of_bounds, errmsg);
+        return;
+    }
+
+    if (lockInReference != "") { // local outputs are handled immediately, the reference period starts now
+        XRTLdisposableCommand reference(lockInReference);
+        reference.add("frequency", (int)lockInFrequency);
+        reference.add("pwm", 128);
+        reference.add("switch", true);
+        sendCommand(reference);
+    }
+    int64_t referenceStart = esp_timer_get_time();
+
+    // phase of the reference at the next sample, the cosine peaks a quarter period after the rising edge
+    double elapsed = (input->timestamp(input->index()) - referenceStart) / 1000000.0;
+    lockIn->reset(lockInFrequency * elapsed - 0.25);
+    input->setLockIn(lockIn);
+
+    nextLockIn = referenceStart + 1000000.0 / lockInRate;
+    debug("lock-in started at %d Hz, time constant: %.3f s", lockInFrequency, lockInTimeConstant);
+}
+
+/**
+ * @brief stop demodulating and switch the reference off
+ */
+void InputModule::stopLockIn() {
+    if (!lockIn) return;
+
+    if (input) input->setLockIn(NULL);
+    delete lockIn;
+    lockIn = NULL;
+
+    if (lockInReference == "") return;
+    XRTLdisposableCommand reference(lockInReference);
+    reference.add("switch", false);
+    sendCommand(reference);
+}
+
+/**
+ * @brief send amplitude and phase of the demodulated input
+ * @note amplitude, x and y refer to the fundamental of the unconverted input voltage in mV, phase in degrees
+ */
+void InputModule::sendLockIn() {
+    int64_t now = esp_timer_get_time();
+    nextLockIn = now + 1000000.0 / lockInRate;
+    lockIn->setSampleRate(input->sampleRate()); // follow the measured rate
+
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "lockIn";
+
+    JsonObject data = payload.createNestedObject("data");
+    data["time"] = now;
+    data["frequency"] = lockInFrequency;
+    data["amplitude"] = lockIn->amplitude();
+    data["phase"] = lockIn->phaseDegrees();
+    data["x"] = lockIn->inPhase();
+    data["y"] = lockIn->quadrature();
+
+    sendEvent(event);
+}
+
 void InputModule::handleCommand(String &controlId, JsonObject &command) {
     if (!isModule(controlId) && controlId != "*") return;
 
@@ -332,6 +846,27 @@ void InputModule::handleCommand(String &controlId, JsonObject &command) {
 
     if (getValue<uint16_t>("averageTime", command, averageTime)) {
         input->averageTime(averageTime);
+        if (isStreaming && blockMode && !startBlocks()) isStreaming = false; // sample period of polled inputs depends on the averaging time
+        sendStatus();
+    }
+
+    String filterChoice;
+    if (getValue<String>("filter", command, filterChoice)) {
+        bool found = false;
+        for (int i = 0; i < 4; i++) {
+            if (filterChoice != filterName[i]) continue;
+            filterType = (filter_t)i;
+            input->setFilter(filterType);
+            found = true;
+            break;
+        }
+        if (!found) {
+            String errmsg = "[";
+            errmsg += id;
+            errmsg += "] unknown filter: ";
+            errmsg += filterChoice;
+            sendError(wrong_type, errmsg);
+        }
         sendStatus();
     }
 
@@ -341,6 +876,108 @@ void InputModule::handleCommand(String &controlId, JsonObject &command) {
         sendStatus();
     }
 
+    bool wasBlockMode = blockMode;
+    bool blockChanged = getValue<bool>("blockMode", command, blockMode);
+    blockChanged |= getValue<bool>("rawBlocks", command, rawBlocks);
+    blockChanged |= getAndConstrainValue<uint16_t>("blockRate", command, blockRate, 1, 1000);
+    if (blockChanged) {
+        if (isStreaming && blockMode) { // restart with the new block length
+            stopStatistics();
+            if (!startBlocks()) isStreaming = false;
+        } else if (isStreaming && wasBlockMode) {
+            stopBlocks();
+            next = esp_timer_get_time();
+            if (statisticsMode) startStatistics();
+        }
+        sendStatus();
+    }
+
+    if (getValue<bool>("statistics", command, statisticsMode)) {
+        if (isStreaming && !blockMode && statisticsMode) {
+            startStatistics();
+        } else {
+            stopStatistics();
+            next = esp_timer_get_time();
+        }
+        sendStatus();
+    }
+
+    uint32_t rate;
+    if (getAndConstrainValue<uint32_t>("sampleRate", command, rate, 1000, 100000)) {
+        if (!input->isContinuous()) {
+            String errmsg = "[";
+            errmsg += id;
+            errmsg += "] sample rate can only be changed in continuous mode";
+            sendError(hardware_failure, errmsg);
+        } else {
+            sampleRate = rate;
+            disarmScope(); // sample indices start over
+            if (!input->setSampleRate(sampleRate)) debug("WARNING: unable to restart sampling, polling instead");
+            if (spectrum && !input->isContinuous()) {
+                stopSpectrum();
+            } else if (spectrum) {
+                spectrum->start(); // discard the samples taken at the old rate
+            }
+            if (lockIn && !input->isContinuous()) {
+                stopLockIn();
+            } else if (lockIn) {
+                startLockIn(); // restart the reference in phase with the new sample indices
+            }
+            if (isStreaming && blockMode && !startBlocks()) isStreaming = false;
+        }
+        sendStatus();
+    }
+
+    JsonObject scopeCommand;
+    if (getValue<JsonObject>("scope", command, scopeCommand)) {
+        bool arm = true;
+        String slope = scopeRising ? "rising" : "falling";
+        getAndConstrainValue<uint32_t>("length", scopeCommand, scopeLength, 1, SCOPE_MAX_LENGTH);
+        getAndConstrainValue<uint8_t>("pre", scopeCommand, scopePreTrigger, 0, 100);
+        getAndConstrainValue<uint16_t>("level", scopeCommand, scopeLevel, 0, SCOPE_MAX_LEVEL);
+        getAndConstrainValue<uint16_t>("hysteresis", scopeCommand, scopeHysteresis, 0, SCOPE_MAX_LEVEL);
+        getValue<bool>("repeat", scopeCommand, scopeRepeat);
+        if (getValue<String>("slope", scopeCommand, slope)) scopeRising = (slope != "falling");
+        getValue<bool>("arm", scopeCommand, arm);
+
+        if (arm) {
+            armScope();
+        } else {
+            disarmScope();
+        }
+        sendStatus();
+    }
+
+    JsonObject spectrumCommand;
+    if (getValue<JsonObject>("spectrum", command, spectrumCommand)) {
+        bool enable = true;
+        getAndConstrainValue<uint32_t>("length", spectrumCommand, spectrumLength, SPECTRUM_MIN_LENGTH, SPECTRUM_MAX_LENGTH);
+        getAndConstrainValue<double>("rate", spectrumCommand, spectrumRate, 0.01, 100.0);
+        getAndConstrainValue<uint8_t>("peaks", spectrumCommand, spectrumPeaks, 0, SPECTRUM_MAX_PEAKS);
+        getValue<bool>("enable", spectrumCommand, enable);
+
+        if (enable) {
+            startSpectrum();
+        } else {
+            stopSpectrum();
+        }
+        sendStatus();
+    }
+
+    JsonObject lockInCommand;
+    if (getValue<JsonObject>("lockIn", command, lockInCommand)) {
+        bool enable = true;
+        stopLockIn(); // reference settings might change
+        getValue<String>("reference", lockInCommand, lockInReference);
+        getAndConstrainValue<uint16_t>("frequency", lockInCommand, lockInFrequency, 1, 40000);
+        getAndConstrainValue<double>("timeConstant", lockInCommand, lockInTimeConstant, 0.001, 100.0);
+        getAndConstrainValue<double>("rate", lockInCommand, lockInRate, 0.01, 50.0);
+        getValue<bool>("enable", lockInCommand, enable);
+
+        if (enable) startLockIn();
+        sendStatus();
+    }
+
     if (!rangeChecking) return;
 
     getValue<double>("upperBound", command, hiBound);
@@ -352,9 +989,14 @@ void InputModule::handleCommand(String &controlId, JsonObject &command) {
 void InputModule::handleInternal(internalEvent eventId, String &sourceId) {
     switch (eventId) {
     case socket_disconnected: {
+        stopLockIn(); // reference output is powered down anyway
+        disarmScope(); // scope and spectrum run independently of the stream
+        stopSpectrum();
         // stop streaming
         if (!isStreaming)
             return;
+        stopBlocks();
+        stopStatistics();
         isStreaming = false;
         debug("stream stopped due to disconnect event");
         return;
@@ -364,47 +1006,17 @@ void InputModule::handleInternal(internalEvent eventId, String &sourceId) {
     }
 }
 
-void InputModule::addConversion(conversion_t type) {
-    if (conversionCount == 16) {
-        Serial.println("WARNING: maximum number of conversions reached");
-        return;
-    }
-
-    switch (type) {
-    case thermistor: {
-        conversion[conversionCount++] = new Thermistor();
-        debug("thermistor conversion added");
-        return;
-    }
-
-    case resistance_voltage_divider: {
-        conversion[conversionCount++] = new ResistanceDivider();
-        debug("resistance conversion added");
-        return;
-    }
-
-    case voltage_voltage_divider: {
-        conversion[conversionCount++] = new VoltageDivider();
-        debug("voltage divider conversion added");
-        return;
-    }
-
-    case map_value: {
-        conversion[conversionCount++] = new MapValue();
-        debug("mapping conversion added");
-        return;
-    }
-
-    case offset: {
-        conversion[conversionCount++] = new Offset();
-        debug("offset conversion added");
-        return;
-    }
-
-    case multiplication: {
-        conversion[conversionCount++] = new Multiplication();
-        debug("multiplication conversion added");
-        return;
-    }
-    }
+/**
+ * @brief compile the conversions after a change
+ * @note in debug mode, the throughput of the conversions is measured
+ */
+void InputModule::compileConversions() {
+    conversions.compile();
+    debug("%d conversions compiled into %d stages", conversions.size(), conversions.stages());
+    if (!debugging || !*debugging) return;
+
+    double individualRate;
+    double compiledRate;
+    conversions.benchmark(individualRate, compiledRate);
+    debug("converted samples per second: %.0f individually, %.0f compiled", individualRate, compiledRate);
 }
\ No newline at end of file
@@ -1,33 +1,70 @@
 #ifndef INPUTMODULE_H
 #define INPUTMODULE_H
 
+#include "XRTLedges.h"
 #include "XRTLinput.h"
-#include "conversions/InputConverter.h"
-#include "conversions/map/MapValue.h"
-#include "conversions/multiply/Multiplication.h"
-#include "conversions/offset/Offset.h"
-#include "conversions/resdiv/ResistanceDivider.h"
-#include "conversions/thermistor/Thermistor.h"
-#include "conversions/voltdiv/VoltageDivider.h"
+#include "XRTLscope.h"
+#include "conversions/ConversionChain.h"
+
+#define INPUT_BLOCK_MAX 2048 // maximum number of samples per block
 
 class InputModule : public XRTLmodule {
 private:
     XRTLinput *input = NULL;
-    // number of conversions currently applied to the input.
-    // maximum number: 16
-    uint8_t conversionCount = 0;
-    conversion_t conversionType[16]; // array that holds the type of each conversion
-    InputConverter *conversion[16];  // array that holds the pointers to the individual instances of the conversion class
+    ConversionChain conversions; // conversions applied to the input voltage
 
     // number of the physical input pin
     // WARNING: ADC2 cannot be used when WiFi is active. Be aware of your board limitations.
     uint8_t pin = 35;
     uint16_t averageTime = 100; // time that the voltage value is averaged for in milli seconds
+    filter_t filterType = moving_average; // filter kernel, its window is set by averageTime
+
+    // continuous sampling: the ADC is sampled at a fixed rate via I2S DMA instead of once per loop
+    // WARNING: ADC1 pins only, not available while a camera module is present (both need I2S0)
+    bool continuous = false;
+    uint32_t sampleRate = 20000; // Hz
 
     bool isStreaming = false;
     int64_t next;
     uint32_t intervalMicroSeconds = 1000000; // TODO: add interface for streaming interval
 
+    // block streaming: every sample is streamed, packed into binary blocks
+    bool blockMode = false;
+    bool rawBlocks = false;        // int16 raw mV instead of converted float32 values
+    uint16_t blockRate = 10;       // blocks per second, sets the number of samples per block
+    uint32_t blockLength = 0;      // samples per block
+    uint16_t *blockSamples = NULL; // capture buffer, mV (Q4)
+    uint8_t *blockData = NULL;     // packed block as sent
+
+    // statistics: summary of all raw samples per streaming interval instead of the filtered value
+    bool statisticsMode = false;
+    XRTLstatistics *statistics = NULL;
+
+    // scope: triggered record of the continuously sampled input, uploaded as single binary event
+    XRTLscope *scope = NULL;
+    uint32_t scopeLength = 1024;   // samples per record
+    uint8_t scopePreTrigger = 20;  // part of the record before the trigger in %
+    uint16_t scopeLevel = 1650;    // trigger level in mV (unconverted input voltage)
+    uint16_t scopeHysteresis = 20; // mV
+    bool scopeRising = true;
+    bool scopeRepeat = false;      // rearm after each record
+
+    // spectrum: amplitude spectrum of the continuously sampled input, sent at a fixed rate
+    XRTLspectrum *spectrum = NULL;
+    uint32_t spectrumLength = 1024; // samples per transform, power of two
+    double spectrumRate = 1.0;      // spectra per second
+    uint8_t spectrumPeaks = 0;      // number of peaks to send, 0: send all bins
+    int64_t nextSpectrum = 0;
+    uint32_t spectrumTime = 0;      // compute time of the last spectrum; µs
+
+    // lock-in: demodulation at the frequency of a square wave reference generated by an OutputModule
+    XRTLlockIn *lockIn = NULL;
+    String lockInReference = "";      // controlId of the reference output, empty: reference driven externally
+    uint16_t lockInFrequency = 1000;  // Hz
+    double lockInTimeConstant = 0.1;  // time constant of each low pass stage; s
+    double lockInRate = 2.0;          // results per second
+    int64_t nextLockIn = 0;
+
     bool rangeChecking = false;
     bool isBinary = false;
     double loBound = 0.0;    // lowest ADC output: 142 mV, 0 will never get triggered
@@ -35,7 +72,16 @@ private:
     uint32_t deadMicroSeconds = 0;
     int64_t nextCheck;
 
-    double value;
+    // interrupt mode for binary inputs: edges are detected by the GPIO interrupt instead of comparing averaged voltages
+    // the pin's digital input thresholds apply, loBound and hiBound are ignored
+    bool edgeInterrupt = false;
+    XRTLedges *edges = NULL;
+    uint32_t lastLatency = 0; // time from the last edge to its event; µs
+    uint32_t maxLatency = 0;  // µs
+    bool heldEdge = false;    // an edge fell into the dead time, its level is reported once the dead time ends
+    bool heldLevel = false;
+
+    double value = 0.0;
     bool lastState;
 
 public:
@@ -44,14 +90,17 @@ public:
     InputModule(String moduleName);
     ~InputModule();
     moduleType type = xrtl_input;
+    moduleType getType();
 
     void setup();
     void loop();
     void stop();
 
+    double read();
+    bool initialized();
+
     void saveSettings(JsonObject &settings);
     void loadSettings(JsonObject &settings);
-    bool conversionDialog();
     bool dialog();
     void setViaSerial();
     bool getStatus(JsonObject &status);
@@ -59,11 +108,36 @@ public:
     void startStreaming();
     void stopStreaming();
 
+    bool startBlocks();
+    void stopBlocks();
+    void sendBlock();
+    size_t packSamples(uint16_t *samples, uint32_t count, uint8_t *target);
+
+    void startStatistics();
+    void stopStatistics();
+    void sendStatistics();
+
+    void armScope();
+    void disarmScope();
+    void sendScope();
+
+    void startSpectrum();
+    void stopSpectrum();
+    void sendSpectrum();
+
+    void startLockIn();
+    void stopLockIn();
+    void sendLockIn();
+
     void handleCommand(String &controlId, JsonObject &command);
 
     void handleInternal(internalEvent eventId, String &sourceId);
 
-    void addConversion(conversion_t conversion);
+    void checkRange(int64_t now);
+    void checkEdges();
+    void triggerEdge(bool level, int64_t time);
+
+    void compileConversions();
 };
 
 #endif
\ No newline at end of file
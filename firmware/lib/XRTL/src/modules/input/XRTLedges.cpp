@@ -0,0 +1,97 @@
+#include "XRTLedges.h"
+
+XRTLedges::~XRTLedges() {
+    end();
+}
+
+/**
+ * @brief interrupt service routine: timestamp the edge and add it to the queue
+ * @param arg pointer to the edge detector
+ */
+void IRAM_ATTR XRTLedges::handleEdge(void *arg) {
+    XRTLedges *edges = (XRTLedges *)arg;
+    int64_t now = esp_timer_get_time();
+    bool level = digitalRead(edges->pin);
+
+    if (level == edges->lastLevel) { // pulse ended before the level could be read
+        edges->missedCount++;
+        return;
+    }
+
+    // a dropped edge must not change the level: the queued levels keep alternating, the next edge counts as missed
+    uint32_t position = edges->writeCount;
+    if (position - edges->readCount >= EDGE_QUEUE_SIZE) {
+        edges->droppedCount++;
+        return;
+    }
+
+    if (edges->lastTime != 0) { // first edge has no predecessor
+        uint32_t interval = now - edges->lastTime;
+        if (interval < edges->shortest) edges->shortest = interval;
+    }
+    edges->lastLevel = level;
+    edges->lastTime = now;
+
+    edges->queue[position & (EDGE_QUEUE_SIZE - 1)] = {now, level};
+    edges->writeCount = position + 1;
+}
+
+/**
+ * @brief start recording edges on a pin
+ * @param inputPin pin to watch, must be configured as input
+ */
+void XRTLedges::begin(uint8_t inputPin) {
+    end();
+
+    pin = inputPin;
+    writeCount = 0;
+    readCount = 0;
+    lastLevel = digitalRead(pin);
+    lastTime = 0;
+
+    attachInterruptArg(pin, handleEdge, this, CHANGE);
+    active = true;
+}
+
+/**
+ * @brief stop recording edges
+ */
+void XRTLedges::end() {
+    if (!active) return;
+    detachInterrupt(pin);
+    active = false;
+}
+
+/**
+ * @brief take the oldest edge from the queue
+ * @param edge receives the edge
+ * @returns true if an edge was available
+ */
+bool XRTLedges::pop(edge_t &edge) {
+    if (readCount == writeCount) return false;
+
+    edge = queue[readCount & (EDGE_QUEUE_SIZE - 1)];
+    readCount++;
+    return true;
+}
+
+/**
+ * @returns number of edges lost because the queue was full
+ */
+uint32_t XRTLedges::dropped() {
+    return droppedCount;
+}
+
+/**
+ * @returns number of pulses that were too short to be detected
+ */
+uint32_t XRTLedges::missed() {
+    return missedCount;
+}
+
+/**
+ * @returns shortest pulse detected so far in µs, 0 if no pulse was detected yet
+ */
+uint32_t XRTLedges::shortestPulse() {
+    return shortest == UINT32_MAX ? 0 : shortest;
+}
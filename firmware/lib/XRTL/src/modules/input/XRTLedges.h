@@ -0,0 +1,45 @@
+#ifndef XRTLEDGES_H
+#define XRTLEDGES_H
+
+#include "common/XRTLfunctions.h"
+
+#define EDGE_QUEUE_SIZE 64 // edges held by the queue, must be a power of two
+
+// edge recorded by the interrupt
+struct edge_t {
+    int64_t time; // esp_timer time of the interrupt; µs
+    bool level;   // level of the pin after the edge
+};
+
+// timestamp every edge on a digital input via GPIO interrupt
+// the interrupt writes into a single producer/single consumer queue, which is drained in the main loop
+class XRTLedges {
+private:
+    uint8_t pin = 0;
+    bool active = false;
+
+    edge_t queue[EDGE_QUEUE_SIZE];
+    volatile uint32_t writeCount = 0;
+    uint32_t readCount = 0;
+    volatile uint32_t droppedCount = 0; // edges lost because the queue was full
+    volatile uint32_t missedCount = 0;  // pulses shorter than the interrupt latency, both edges passed before the level was read
+
+    volatile bool lastLevel = false;
+    volatile int64_t lastTime = 0;
+    volatile uint32_t shortest = UINT32_MAX; // shortest time between two edges that were both detected; µs
+
+    static void IRAM_ATTR handleEdge(void *arg);
+
+public:
+    ~XRTLedges();
+
+    void begin(uint8_t inputPin);
+    void end();
+    bool pop(edge_t &edge);
+
+    uint32_t dropped();
+    uint32_t missed();
+    uint32_t shortestPulse();
+};
+
+#endif
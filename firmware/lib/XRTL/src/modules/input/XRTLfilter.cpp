@@ -0,0 +1,132 @@
+#include "XRTLfilter.h"
+
+/**
+ * @brief get the longest window a kernel supports
+ * @param filterKernel kernel to check
+ * @returns maximum window length in samples
+ */
+uint16_t XRTLfilter::maxLength(filter_t filterKernel) {
+    if (filterKernel == median) return FILTER_MEDIAN_LENGTH;
+    return FILTER_MAX_LENGTH;
+}
+
+/**
+ * @brief select the kernel and its window length
+ * @param filterKernel kernel used for filtering
+ * @param windowLength number of samples in the window, constrained to maxLength()
+ * @note call reset() afterwards to initialize the filter
+ */
+void XRTLfilter::configure(filter_t filterKernel, uint16_t windowLength) {
+    kernel = filterKernel;
+    length = (windowLength > 0) ? windowLength : 1;
+    if (length > maxLength(kernel)) length = maxLength(kernel);
+
+    // exponential: same center of mass as a moving average of the same length
+    alpha = (2LL << 30) / (length + 1);
+
+    // biquad: 2nd order Butterworth low pass, cutoff at the -3 dB point of a moving average of the same length
+    double w0 = 2.0 * M_PI * ((length > 1) ? 0.443 / length : 0.4);
+    double cosW0 = cos(w0);
+    double alphaQ = sin(w0) / sqrt(2.0); // sin(w0) / (2 * Q) with Q = 1/sqrt(2)
+    double a0 = 1.0 + alphaQ;
+    b0 = llround((1.0 - cosW0) / 2.0 / a0 * (1LL << 30));
+    b1 = llround((1.0 - cosW0) / a0 * (1LL << 30));
+    b2 = b0;
+    a1 = llround(-2.0 * cosW0 / a0 * (1LL << 30));
+    a2 = llround((1.0 - alphaQ) / a0 * (1LL << 30));
+}
+
+/**
+ * @brief initialize the filter as if it had received a constant input for a long time
+ * @param sample initial value in mV (Q4)
+ */
+void XRTLfilter::reset(uint16_t sample) {
+    for (uint16_t i = 0; i < length; i++) {
+        window[i] = sample;
+    }
+    for (uint16_t i = 0; i < length && i < FILTER_MEDIAN_LENGTH; i++) {
+        sorted[i] = sample;
+    }
+    position = 0;
+    filled = length;
+    sum = (uint32_t)sample * length;
+
+    output = (int32_t)sample << (16 - FILTER_FRACTION);
+    x1 = output;
+    x2 = output;
+    y1 = output;
+    y2 = output;
+}
+
+/**
+ * @brief feed the next sample into the filter
+ * @param sample voltage in mV (Q4)
+ */
+void XRTLfilter::push(uint16_t sample) {
+    int32_t x = (int32_t)sample << (16 - FILTER_FRACTION);
+
+    switch (kernel) {
+    case moving_average: {
+        if (filled < length) {
+            filled++;
+        } else {
+            sum -= window[position];
+        }
+        window[position] = sample;
+        sum += sample;
+        if (++position == length) position = 0;
+
+        output = ((uint64_t)sum << (16 - FILTER_FRACTION)) / filled;
+        return;
+    }
+
+    case exponential: {
+        output += ((int64_t)(x - output) * alpha) >> 30;
+        return;
+    }
+
+    case median: {
+        uint16_t count = filled;
+        if (filled == length) { // drop the oldest sample from the sorted window
+            uint16_t i = 0;
+            while (sorted[i] != window[position]) i++;
+            memmove(&sorted[i], &sorted[i + 1], (count - i - 1) * sizeof(uint16_t));
+            count--;
+        } else {
+            filled++;
+        }
+
+        uint16_t j = count;
+        while (j > 0 && sorted[j - 1] > sample) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = sample;
+
+        window[position] = sample;
+        if (++position == length) position = 0;
+
+        uint32_t middle = sorted[filled / 2];
+        if (filled % 2 == 0) middle = (middle + sorted[filled / 2 - 1]) / 2;
+        output = middle << (16 - FILTER_FRACTION);
+        return;
+    }
+
+    case biquad: {
+        int64_t acc = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = (int32_t)((acc + (1LL << 29)) >> 30);
+        output = y1;
+        return;
+    }
+    }
+}
+
+/**
+ * @returns current filter output in mV
+ */
+double XRTLfilter::read() {
+    return ((double)output) / 65536.0;
+}
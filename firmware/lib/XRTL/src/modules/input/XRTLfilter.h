@@ -0,0 +1,67 @@
+#ifndef XRTLFILTER_H
+#define XRTLFILTER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILTER_MAX_LENGTH 1024  // maximum window of the moving average, longer windows are decimated in advance
+#define FILTER_MEDIAN_LENGTH 63 // maximum window of the median, insertion into the sorted window is O(n)
+#define FILTER_FRACTION 4       // samples are fed in mV with 4 fractional bits (Q4)
+
+enum filter_t {
+    moving_average,
+    exponential,
+    median,
+    biquad
+};
+
+static const char *filterName[4] = {
+    "average",
+    "exponential",
+    "median",
+    "biquad"
+};
+
+// fixed-point filter kernels, updated with every sample
+// the window length sets the time constant of every kernel: the exponential and biquad kernels
+// are tuned to roughly the same smoothing as a moving average of that length
+// Free of Arduino dependencies to allow testing on the host (test/native/test_filter).
+class XRTLfilter {
+private:
+    filter_t kernel = moving_average;
+    uint16_t length = 1;
+
+    // moving average and median: window of the last samples (Q4)
+    uint16_t window[FILTER_MAX_LENGTH];
+    uint16_t position = 0;
+    uint16_t filled = 0;
+    uint32_t sum = 0;
+    uint16_t sorted[FILTER_MEDIAN_LENGTH]; // median only: window in ascending order
+
+    // exponential: output in Q16, smoothing factor in Q30
+    int64_t alpha = 0;
+
+    // biquad, direct form I: coefficients in Q30, in- and output in Q16
+    int64_t b0 = 0;
+    int64_t b1 = 0;
+    int64_t b2 = 0;
+    int64_t a1 = 0;
+    int64_t a2 = 0;
+    int32_t x1 = 0;
+    int32_t x2 = 0;
+    int32_t y1 = 0;
+    int32_t y2 = 0;
+
+    int32_t output = 0; // Q16
+
+public:
+    static uint16_t maxLength(filter_t filterKernel);
+
+    void configure(filter_t filterKernel, uint16_t windowLength);
+    void reset(uint16_t sample);
+    void push(uint16_t sample);
+    double read();
+};
+
+#endif
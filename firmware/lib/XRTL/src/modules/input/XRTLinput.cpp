@@ -1,5 +1,9 @@
 #include "XRTLinput.h"
 
+XRTLinput::~XRTLinput() {
+    delete sampler;
+}
+
 /**
  * @brief initialize the pin as input
  * @param inputPin pin number of the pin to use as input
@@ -10,47 +14,285 @@ void XRTLinput::attach(uint8_t inputPin) {
     pin = inputPin;
     pinMode(pin, INPUT);
 
-    voltage = analogReadMilliVolts(pin); // make sure voltage is initialized with real value (avoiding trigger thresholds)
+    configureFilter();
+    filter.reset(analogReadMilliVolts(pin) << FILTER_FRACTION); // make sure the filter is initialized with real value (avoiding trigger thresholds)
 
-    next = esp_timer_get_time() + averageMicroSeconds;
+    rateStart = esp_timer_get_time();
+    next = rateStart + slotMicroSeconds;
     return;
 }
 
 /**
- * @brief set the averaging time of the buffer
+ * @brief initialize the pin as continuously sampled input
+ * @param inputPin pin number of the pin to use as input, must be attached to ADC1
+ * @param sampleRate sample rate in Hz
+ * @returns true if continuous sampling started, false if the pin needs to be polled instead
+ * @note the filter window holds a fixed number of samples, independent of the processing load
+ */
+bool XRTLinput::attach(uint8_t inputPin, uint32_t sampleRate) {
+    pin = inputPin;
+    pinMode(pin, INPUT);
+    uint16_t initial = analogReadMilliVolts(pin) << FILTER_FRACTION; // must happen before the I2S driver takes over the ADC
+
+    sampler = new XRTLsampler;
+    if (!sampler->begin(pin, sampleRate)) {
+        delete sampler;
+        sampler = NULL;
+        attach(inputPin);
+        return false;
+    }
+
+    configureFilter(); // window length depends on the sample rate
+    filter.reset(initial);
+    return true;
+}
+
+/**
+ * @brief set the averaging time of the filter
  * @param measurementTime time in ms to average the voltage for
- * @note the buffer will average the value for this amount of time, the number of averaged values depends on processing load
+ * @note the filter output is updated with every sample, not only once per averaging time
  */
 void XRTLinput::averageTime(int64_t measurementTime) {
     averageMicroSeconds = 1000 * measurementTime;
+    configureFilter();
+}
+
+/**
+ * @brief select the filter kernel
+ * @param filterKernel kernel used for filtering, the window length is set by the averaging time
+ */
+void XRTLinput::setFilter(filter_t filterKernel) {
+    kernel = filterKernel;
+    configureFilter();
+}
+
+/**
+ * @brief derive decimation and window length from averaging time, sample rate and kernel
+ * @note resets the filter to the current output
+ */
+void XRTLinput::configureFilter() {
+    double rate = sampler ? sampler->sampleRate() : INPUT_POLL_RATE;
+    uint32_t windowSamples = max((uint32_t)1, (uint32_t)(rate * averageMicroSeconds / 1000000.0));
+    uint16_t maxLength = XRTLfilter::maxLength(kernel);
+
+    // windows exceeding the filter are averaged down in advance
+    decimation = (windowSamples + maxLength - 1) / maxLength;
+    slotMicroSeconds = 1000000 * decimation / INPUT_POLL_RATE;
+
+    uint16_t initial = (uint16_t)(readMilliVolts() * (1 << FILTER_FRACTION));
+    filter.configure(kernel, windowSamples / decimation);
+    filter.reset(initial);
+    buffer = 0;
+    sampleCount = 0;
 }
 
 /**
- * @brief fill the buffer, average and deliver value
+ * @brief fill the buffer, filter and deliver value
  * @note should be called as frequently as possible
  */
 void XRTLinput::loop() {
-    now = esp_timer_get_time();
-    if (now < next) { // average time not reached, keep going
-        buffer += analogReadMilliVolts(pin);
-        sampleCount++;
-        return;
-    } else { // average time over, store averaged value
-        next = now + averageMicroSeconds;
-        if (sampleCount == 0) { // no measurment taken, fill buffer with single value
-            buffer += analogReadMilliVolts(pin);
-            sampleCount++;
+    if (sampler) {
+        uint16_t block[INPUT_BLOCK_SIZE];
+        uint32_t count;
+        while ((count = sampler->read(block, INPUT_BLOCK_SIZE)) > 0) {
+            uint32_t index = sampler->index() - count; // index of block[0]
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t milliVolts = sampler->toMilliVolts(block[i]);
+                if (scope) scope->push(milliVolts << FILTER_FRACTION, index + i);
+                if (statistics) statistics->push(milliVolts << FILTER_FRACTION);
+                if (spectrum) spectrum->push(milliVolts << FILTER_FRACTION, index + i);
+                if (lockIn) lockIn->push(milliVolts << FILTER_FRACTION);
+                if (capture) store(milliVolts << FILTER_FRACTION, captureCount == 0 ? sampler->timestamp(index + i) : 0);
+                buffer += milliVolts;
+                if (++sampleCount < decimation) continue;
+
+                filter.push((buffer << FILTER_FRACTION) / sampleCount);
+                buffer = 0;
+                sampleCount = 0;
+            }
         }
-        voltage = ((double)buffer) / ((double)sampleCount);
-        buffer = 0;
-        sampleCount = 0;
+        return;
+    }
+
+    now = esp_timer_get_time();
+    uint32_t milliVolts = analogReadMilliVolts(pin);
+    if (statistics) statistics->push(milliVolts << FILTER_FRACTION);
+    buffer += milliVolts;
+    sampleCount++;
+    rateCount++;
+
+    if (now - rateStart >= averageMicroSeconds) {
+        pollRate = ((double)rateCount) * 1000000.0 / ((double)(now - rateStart));
+        rateCount = 0;
+        rateStart = now;
+    }
+
+    if (now < next) return; // slot not over, keep going
+
+    // feed the slot average, repeated for slots missed due to processing load to keep the time scale
+    uint16_t sample = (buffer << FILTER_FRACTION) / sampleCount;
+    int64_t slots = (now - next) / slotMicroSeconds + 1;
+    for (int64_t i = 0; i < min(slots, (int64_t)FILTER_MAX_LENGTH); i++) {
+        filter.push(sample);
+        if (capture) store(sample, next + i * slotMicroSeconds);
     }
+    next += slots * slotMicroSeconds;
+    buffer = 0;
+    sampleCount = 0;
 }
 
 /**
- * @brief deliver the last averaged value
+ * @brief deliver the filtered value
  * @returns voltage in mV as float
  */
 double XRTLinput::readMilliVolts() {
-    return voltage;
-}
\ No newline at end of file
+    return filter.read();
+}
+
+/**
+ * @brief add a sample to the capture
+ * @param sample voltage in mV (Q4)
+ * @param time time the sample was taken; µs
+ */
+void XRTLinput::store(uint16_t sample, int64_t time) {
+    if (captureCount >= captureLength) return;
+    if (captureCount == 0) captureTime = time;
+    capture[captureCount++] = sample;
+}
+
+/**
+ * @brief record the next samples entering the filter
+ * @param target buffer receiving the samples in mV (Q4)
+ * @param length number of samples to capture
+ * @note samples are spaced by samplePeriod(), the capture is complete once the buffer is full
+ */
+void XRTLinput::startCapture(uint16_t *target, uint32_t length) {
+    capture = target;
+    captureLength = length;
+    captureCount = 0;
+}
+
+/**
+ * @brief stop capturing, the buffer will not be accessed anymore
+ */
+void XRTLinput::stopCapture() {
+    capture = NULL;
+    captureLength = 0;
+    captureCount = 0;
+}
+
+/**
+ * @returns true if the capture buffer is full
+ */
+bool XRTLinput::captureComplete() {
+    return (capture && captureCount >= captureLength);
+}
+
+/**
+ * @returns time of the first captured sample; µs
+ */
+int64_t XRTLinput::captureStart() {
+    return captureTime;
+}
+
+/**
+ * @returns time between two captured samples; µs
+ */
+double XRTLinput::samplePeriod() {
+    if (sampler) return 1000000.0 / sampler->sampleRate();
+    return slotMicroSeconds;
+}
+
+/**
+ * @brief feed every sample into a scope
+ * @param target scope receiving the samples, NULL to detach
+ * @note continuous mode only, samples are not passed on when polling
+ */
+void XRTLinput::setScope(XRTLscope *target) {
+    scope = target;
+}
+
+/**
+ * @brief feed every raw sample into a statistics window
+ * @param target statistics receiving the samples, NULL to detach
+ * @note samples are passed on before averaging, polled inputs deliver every single read
+ */
+void XRTLinput::setStatistics(XRTLstatistics *target) {
+    statistics = target;
+}
+
+/**
+ * @brief feed every sample into a spectrum
+ * @param target spectrum receiving the samples, NULL to detach
+ * @note continuous mode only, samples are not passed on when polling
+ */
+void XRTLinput::setSpectrum(XRTLspectrum *target) {
+    spectrum = target;
+}
+
+/**
+ * @brief feed every sample into a lock-in demodulator
+ * @param target demodulator receiving the samples, NULL to detach
+ * @note continuous mode only, samples are not passed on when polling
+ */
+void XRTLinput::setLockIn(XRTLlockIn *target) {
+    lockIn = target;
+}
+
+/**
+ * @returns index of the next sample to be processed in continuous mode, 0 when polling
+ */
+uint32_t XRTLinput::index() {
+    if (sampler) return sampler->index();
+    return 0;
+}
+
+/**
+ * @brief estimate the time a sample was taken
+ * @param sampleIndex index of the sample in continuous mode
+ * @returns esp_timer time of the sample in µs, current time when polling
+ */
+int64_t XRTLinput::timestamp(uint32_t sampleIndex) {
+    if (sampler) return sampler->timestamp(sampleIndex);
+    return esp_timer_get_time();
+}
+
+/**
+ * @returns true if the input is sampled continuously at a fixed rate
+ */
+bool XRTLinput::isContinuous() {
+    return (sampler != NULL);
+}
+
+/**
+ * @brief restart continuous sampling at a different rate
+ * @param sampleRate new sample rate in Hz
+ * @returns true if sampling continues at the new rate
+ * @note sample indices start over, the filter is reset
+ */
+bool XRTLinput::setSampleRate(uint32_t sampleRate) {
+    if (!sampler) return false;
+
+    uint16_t current = (uint16_t)(readMilliVolts() * (1 << FILTER_FRACTION));
+    sampler->end();
+    if (!sampler->begin(pin, sampleRate)) {
+        delete sampler;
+        sampler = NULL;
+        attach(pin);
+        return false;
+    }
+
+    configureFilter();
+    filter.reset(current);
+    return true;
+}
+
+/**
+ * @brief get the effective sample rate
+ * @returns samples per second that entered the filter
+ * @note continuous mode reports the measured rate of the sampler
+ */
+double XRTLinput::sampleRate() {
+    if (sampler) return sampler->sampleRate();
+    return pollRate;
+}
@@ -1,9 +1,21 @@
 #ifndef XRTLINPUT_H
 #define XRTLINPUT_H
 
+#include "XRTLfilter.h"
+#include "XRTLlockIn.h"
+#include "XRTLsampler.h"
+#include "XRTLscope.h"
+#include "XRTLspectrum.h"
+#include "XRTLstatistics.h"
 #include "common/XRTLfunctions.h"
 
-// averaging and storing input value on an input pin
+#define INPUT_BLOCK_SIZE 64  // samples read from the sampler at once
+#define INPUT_POLL_RATE 1000 // rate in Hz at which polled values are fed into the filter
+
+static_assert(LOCKIN_FRACTION == FILTER_FRACTION, "lock-in and filter must agree on the sample format");
+static_assert(SPECTRUM_FRACTION == FILTER_FRACTION, "spectrum and filter must agree on the sample format");
+
+// filtering and storing input value on an input pin
 class XRTLinput {
 private:
     uint8_t pin = 35;
@@ -12,16 +24,64 @@ private:
     int64_t now = 0;
     int64_t next = 0;
 
-    uint16_t sampleCount = 0;
-    // buffer used for averaging values, 64 bit should prevent overflows for roughly 60 years at normal clock speed
-    uint64_t buffer = 0;
-    double voltage = 0.0;
+    // continuous mode: samples are taken at a fixed rate by the sampler
+    XRTLsampler *sampler = NULL;
+
+    // the filter runs at a fixed rate: every slot is averaged into a single filter input
+    // continuous: a slot holds a fixed number of samples, polling: a slot lasts a fixed time
+    filter_t kernel = moving_average;
+    XRTLfilter filter;
+    uint32_t decimation = 1;           // samples (continuous) or ms (polling) per filter input
+    int64_t slotMicroSeconds = 1000;   // polling only
+    uint32_t sampleCount = 0;
+    uint64_t buffer = 0;               // sum of the samples in the current slot in mV
+
+    // polling: measure the number of reads per second
+    uint32_t rateCount = 0;
+    int64_t rateStart = 0;
+    double pollRate = 0.0;
+
+    // capture: every filter input is additionally stored for block streaming
+    uint16_t *capture = NULL;    // samples in mV (Q4)
+    uint32_t captureLength = 0;
+    uint32_t captureCount = 0;
+    int64_t captureTime = 0;     // time of the first captured sample; µs
+
+    void store(uint16_t sample, int64_t time);
+
+    XRTLscope *scope = NULL; // receives every sample in continuous mode
+    XRTLstatistics *statistics = NULL; // receives every raw sample
+    XRTLspectrum *spectrum = NULL;     // receives every sample in continuous mode
+    XRTLlockIn *lockIn = NULL;         // receives every sample in continuous mode
+
+    void configureFilter();
 
 public:
+    ~XRTLinput();
+
     void attach(uint8_t inputPin);
+    bool attach(uint8_t inputPin, uint32_t sampleRate);
     void averageTime(int64_t measurementTime);
+    void setFilter(filter_t filterKernel);
     void loop();
     double readMilliVolts();
+
+    void startCapture(uint16_t *target, uint32_t length);
+    void stopCapture();
+    bool captureComplete();
+    int64_t captureStart();
+    double samplePeriod();
+
+    void setScope(XRTLscope *target);
+    void setStatistics(XRTLstatistics *target);
+    void setSpectrum(XRTLspectrum *target);
+    void setLockIn(XRTLlockIn *target);
+    uint32_t index();
+    int64_t timestamp(uint32_t sampleIndex);
+
+    bool isContinuous();
+    bool setSampleRate(uint32_t sampleRate);
+    double sampleRate();
 };
 
-#endif
\ No newline at end of file
+#endif
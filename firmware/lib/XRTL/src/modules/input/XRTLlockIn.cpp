@@ -0,0 +1,142 @@
+#include "XRTLlockIn.h"
+
+int16_t XRTLlockIn::cosine[1 << LOCKIN_TABLE_BITS];
+bool XRTLlockIn::tableReady = false;
+
+/**
+ * @brief set reference frequency, sample rate and time constant
+ * @param referenceFrequency frequency of the reference in Hz, must be below half the sample rate
+ * @param sampleRate rate at which push() is called in Hz
+ * @param timeConstant time constant of each low pass stage in s
+ * @returns false if the reference frequency can not be demodulated at this sample rate
+ * @note call reset() afterwards to set the phase and clear the low pass
+ */
+bool XRTLlockIn::configure(double referenceFrequency, double sampleRate, double timeConstant) {
+    if (!tableReady) {
+        for (int i = 0; i < (1 << LOCKIN_TABLE_BITS); i++) {
+            cosine[i] = lround(32767.0 * cos(2.0 * M_PI * i / (1 << LOCKIN_TABLE_BITS)));
+        }
+        tableReady = true;
+    }
+
+    if (referenceFrequency <= 0.0 || referenceFrequency >= sampleRate / 2) return false;
+
+    frequency = referenceFrequency;
+    setSampleRate(sampleRate);
+
+    decimation = (sampleRate >= 2 * LOCKIN_FILTER_RATE) ? (uint32_t)(sampleRate / LOCKIN_FILTER_RATE) : 1;
+    double filterRate = sampleRate / decimation;
+    if (timeConstant < 1.0 / filterRate) timeConstant = 1.0 / filterRate;
+    alpha = 1.0 - exp(-1.0 / (filterRate * timeConstant));
+    return true;
+}
+
+/**
+ * @brief update the NCO to a new estimate of the sample rate
+ * @param sampleRate rate at which push() is called in Hz
+ * @note keeps the current phase, used to follow the measured rate of the sampler
+ */
+void XRTLlockIn::setSampleRate(double sampleRate) {
+    rate = sampleRate;
+    increment = (uint32_t)llround(frequency / rate * 4294967296.0);
+}
+
+/**
+ * @brief clear the low pass and set the phase of the NCO
+ * @param startPhase phase of the reference at the next sample, a full turn is 1.0
+ */
+void XRTLlockIn::reset(double startPhase) {
+    phase = (uint32_t)llround((startPhase - floor(startPhase)) * 4294967296.0);
+    count = 0;
+    sumX = 0;
+    sumY = 0;
+    sumC = 0;
+    sumS = 0;
+    sumDC = 0;
+    primed = 0;
+}
+
+/**
+ * @brief demodulate the next sample
+ * @param sample voltage in mV (Q4)
+ */
+void XRTLlockIn::push(uint16_t sample) {
+    if (increment == 0) return;
+
+    int32_t x = (int32_t)sample - level;
+    uint32_t mask = (1 << LOCKIN_TABLE_BITS) - 1;
+    uint32_t index = ((phase >> (31 - LOCKIN_TABLE_BITS)) + 1) >> 1; // rounded to the nearest entry
+    uint32_t quarter = 1 << (LOCKIN_TABLE_BITS - 2);
+    int32_t c = cosine[index & mask];
+    int32_t s = cosine[(index - quarter) & mask]; // sin(a) = cos(a - 90°)
+    sumX += x * c;
+    sumY -= x * s;
+    sumC += c;
+    sumS += s;
+    sumDC += sample;
+    phase += increment;
+
+    if (++count < decimation) return;
+
+    // x * cos averages to A/2 cos(phi) for an input of A cos(wt + phi), scale to the amplitude in mV
+    double scale = 2.0 / count / 32767.0 / (1 << LOCKIN_FRACTION);
+    double x0 = sumX * scale;
+    double y0 = sumY * scale;
+    double dc = ((double)sumDC) / count;
+
+    if (primed == 2) {
+        // a block rarely spans whole periods: remove the estimated fundamental (x cos - y sin) from the mean,
+        // otherwise the DC level ripples at the reference frequency and biases the products
+        dc -= (x2 * sumC - y2 * sumS) * (1 << LOCKIN_FRACTION) / 32767.0 / count;
+
+        x1 += (x0 - x1) * alpha;
+        y1 += (y0 - y1) * alpha;
+        x2 += (x1 - x2) * alpha;
+        y2 += (y1 - y2) * alpha;
+        offset += (dc - offset) * alpha;
+    } else if (primed == 1) { // products are free of the DC level from now on
+        x1 = x2 = x0;
+        y1 = y2 = y0;
+        primed = 2;
+    } else {
+        offset = dc;
+        primed = 1;
+    }
+    level = lround(offset);
+
+    count = 0;
+    sumX = 0;
+    sumY = 0;
+    sumC = 0;
+    sumS = 0;
+    sumDC = 0;
+}
+
+/**
+ * @returns in phase component of the fundamental; mV
+ */
+double XRTLlockIn::inPhase() {
+    return x2;
+}
+
+/**
+ * @returns quadrature component of the fundamental; mV
+ */
+double XRTLlockIn::quadrature() {
+    return y2;
+}
+
+/**
+ * @returns amplitude of the fundamental at the reference frequency; mV
+ * @note a square wave of peak to peak height S has a fundamental of amplitude 2S/pi
+ */
+double XRTLlockIn::amplitude() {
+    return sqrt(x2 * x2 + y2 * y2);
+}
+
+/**
+ * @returns phase of the fundamental relative to the reference in degrees
+ */
+double XRTLlockIn::phaseDegrees() {
+    return atan2(y2, x2) * 180.0 / M_PI;
+}
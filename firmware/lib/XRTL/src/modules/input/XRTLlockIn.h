@@ -0,0 +1,56 @@
+#ifndef XRTLLOCKIN_H
+#define XRTLLOCKIN_H
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCKIN_TABLE_BITS 10    // cosine table of 1024 entries, phase resolution 0.35°
+#define LOCKIN_FILTER_RATE 1000 // rate of the low pass stages in Hz, products are summed down to this rate in advance
+#define LOCKIN_FRACTION 4       // samples are fed in mV with 4 fractional bits (Q4), same as FILTER_FRACTION
+
+// synchronous demodulation of a continuously sampled input at the frequency of a reference
+// every sample is multiplied by the cosine and sine of a numerically controlled oscillator (NCO) and accumulated in
+// fixed point. The sums are smoothed by two cascaded first order low pass stages with the configured time constant.
+// Free of Arduino dependencies to allow testing on the host (test/native/test_lockin).
+class XRTLlockIn {
+private:
+    static int16_t cosine[1 << LOCKIN_TABLE_BITS]; // Q15
+    static bool tableReady;
+
+    double frequency = 0.0; // reference frequency in Hz
+    double rate = 1.0;      // sample rate in Hz
+    uint32_t phase = 0;     // NCO phase, a full turn is 2^32
+    uint32_t increment = 0; // NCO phase per sample
+
+    // accumulation: products of the input (Q4, DC removed) and the NCO (Q15)
+    uint32_t decimation = 1;
+    uint32_t count = 0;
+    int64_t sumX = 0;   // in phase
+    int64_t sumY = 0;   // quadrature
+    int32_t sumC = 0;   // NCO cosine, to remove the fundamental from the DC level
+    int32_t sumS = 0;   // NCO sine
+    uint32_t sumDC = 0;  // input; mV (Q4)
+    double offset = 0.0; // tracked DC level of the input; mV (Q4)
+    int32_t level = 0;   // offset as subtracted from every sample; mV (Q4)
+
+    // low pass: two cascaded first order stages; mV
+    double alpha = 1.0;
+    double x1 = 0.0;
+    double y1 = 0.0;
+    double x2 = 0.0;
+    double y2 = 0.0;
+    uint8_t primed = 0; // accumulations since reset: the first one sets the DC level, the second one the stages
+
+public:
+    bool configure(double referenceFrequency, double sampleRate, double timeConstant);
+    void setSampleRate(double sampleRate);
+    void reset(double startPhase);
+    void push(uint16_t sample);
+
+    double inPhase();
+    double quadrature();
+    double amplitude();
+    double phaseDegrees();
+};
+
+#endif
@@ -0,0 +1,238 @@
+#include "XRTLsampler.h"
+
+XRTLsampler::~XRTLsampler() {
+    end();
+}
+
+/**
+ * @brief task moving completed DMA buffers into the ring buffer
+ * @param arg pointer to the sampler
+ * @note blocks until the next DMA buffer is complete, hence the sampling does not depend on the main loop
+ */
+void samplerTask(void *arg) {
+    XRTLsampler *sampler = (XRTLsampler *)arg;
+    uint16_t block[SAMPLER_DMA_LENGTH];
+    size_t bytesRead = 0;
+
+    while (true) {
+        if (i2s_read(I2S_NUM_0, block, sizeof(block), &bytesRead, portMAX_DELAY) != ESP_OK) continue;
+        int64_t now = esp_timer_get_time();
+
+        uint32_t count = (bytesRead / sizeof(uint16_t)) & ~1;
+        uint32_t position = sampler->writeCount;
+        // the I2S ADC mode delivers the two samples of each 32 bit word in swapped order
+        for (uint32_t i = 0; i < count; i += 2) {
+            sampler->ring[(position + i) & (SAMPLER_BUFFER_SIZE - 1)] = block[i + 1];
+            sampler->ring[(position + i + 1) & (SAMPLER_BUFFER_SIZE - 1)] = block[i];
+        }
+        __sync_synchronize(); // samples must be visible before the count is updated
+        sampler->writeCount = position + count;
+
+        portENTER_CRITICAL(&sampler->timingMux);
+        if (sampler->firstBlockTime == 0) {
+            sampler->firstBlockTime = now;
+            sampler->firstBlockEnd = position + count;
+        }
+        sampler->lastBlockTime = now;
+        sampler->lastBlockEnd = position + count;
+        portEXIT_CRITICAL(&sampler->timingMux);
+    }
+}
+
+/**
+ * @brief start sampling a pin continuously
+ * @param pin pin to sample, must be attached to ADC1
+ * @param sampleRate sample rate in Hz
+ * @returns true if sampling started
+ * @note uses 11 dB attenuation and 12 bit resolution like analogReadMilliVolts()
+ */
+bool XRTLsampler::begin(uint8_t pin, uint32_t sampleRate) {
+    return begin(&pin, 1, sampleRate);
+}
+
+/**
+ * @brief start scanning several pins continuously
+ * @param pins pins to sample in this order, must be attached to ADC1
+ * @param pinCount number of pins, up to SAMPLER_MAX_CHANNELS
+ * @param sampleRate total sample rate in Hz, each pin is sampled at sampleRate / pinCount
+ * @returns true if sampling started
+ * @note the ADC channel of every sample is available via channelOf()
+ */
+bool XRTLsampler::begin(const uint8_t *pins, uint8_t pinCount, uint32_t sampleRate) {
+    if (task || pinCount == 0 || pinCount > SAMPLER_MAX_CHANNELS) return false;
+
+    adc_digi_pattern_table_t pattern[SAMPLER_MAX_CHANNELS];
+    for (int i = 0; i < pinCount; i++) {
+        int8_t channel = digitalPinToAnalogChannel(pins[i]);
+        if (channel < 0 || channel >= SOC_ADC_MAX_CHANNEL_NUM) return false; // ADC2 is not supported by the I2S mode
+
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].bit_width = ADC_WIDTH_BIT_12;
+        pattern[i].channel = channel;
+    }
+    adc1_channel_t channel = (adc1_channel_t)pattern[0].channel;
+
+    rate = sampleRate;
+
+    i2s_config_t config = {};
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    config.sample_rate = rate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+    config.dma_buf_count = 8;
+    config.dma_buf_len = SAMPLER_DMA_LENGTH;
+    config.use_apll = false;
+
+    if (!claimI2S("sampler")) return false;
+    if (i2s_driver_install(I2S_NUM_0, &config, 0, NULL) != ESP_OK) {
+        releaseI2S();
+        return false;
+    }
+
+    if (i2s_set_adc_mode(ADC_UNIT_1, channel) != ESP_OK) {
+        i2s_driver_uninstall(I2S_NUM_0);
+        releaseI2S();
+        return false;
+    }
+    for (int i = 0; i < pinCount; i++) {
+        adc1_config_channel_atten((adc1_channel_t)pattern[i].channel, ADC_ATTEN_DB_11);
+    }
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &calibration);
+
+    writeCount = 0;
+    readCount = 0;
+    overflowCount = 0;
+    firstBlockTime = 0;
+    lastBlockTime = 0;
+
+    i2s_adc_enable(I2S_NUM_0);
+
+    // enabling restores the single channel pattern of i2s_set_adc_mode(), extend it afterwards
+    if (pinCount > 1) {
+        adc_digi_config_t scan = {};
+        scan.conv_limit_en = false;
+        scan.conv_limit_num = 255;
+        scan.adc1_pattern_len = pinCount;
+        scan.adc1_pattern = pattern;
+        scan.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        scan.format = ADC_DIGI_FORMAT_12BIT;
+        adc_digi_controller_config(&scan);
+    }
+
+    // core 0: keep the copying away from the main loop
+    xTaskCreatePinnedToCore(samplerTask, "sampler", 4096, this, 5, &task, 0);
+    return true;
+}
+
+/**
+ * @brief stop sampling and release the I2S peripheral
+ */
+void XRTLsampler::end() {
+    if (!task) return;
+
+    vTaskDelete(task);
+    task = NULL;
+
+    i2s_adc_disable(I2S_NUM_0);
+    i2s_driver_uninstall(I2S_NUM_0);
+    releaseI2S();
+}
+
+/**
+ * @returns number of samples ready to be read
+ */
+uint32_t XRTLsampler::available() {
+    return min(writeCount - readCount, (uint32_t)(SAMPLER_BUFFER_SIZE - SAMPLER_DMA_LENGTH));
+}
+
+/**
+ * @brief copy samples from the ring buffer
+ * @param buffer store the raw samples here
+ * @param maxCount maximum number of samples to copy
+ * @returns number of samples copied
+ * @note if the reader fell behind, the oldest samples are skipped and counted as overflow
+ */
+uint32_t XRTLsampler::read(uint16_t *buffer, uint32_t maxCount) {
+    uint32_t written = writeCount;
+    __sync_synchronize();
+
+    // the block currently written by the task might overlap the oldest samples
+    if (written - readCount > SAMPLER_BUFFER_SIZE - SAMPLER_DMA_LENGTH) {
+        readCount = written - (SAMPLER_BUFFER_SIZE - SAMPLER_DMA_LENGTH);
+        overflowCount++;
+    }
+
+    uint32_t count = min(written - readCount, maxCount);
+    for (uint32_t i = 0; i < count; i++) {
+        buffer[i] = ring[(readCount + i) & (SAMPLER_BUFFER_SIZE - 1)];
+    }
+    readCount += count;
+
+    return count;
+}
+
+/**
+ * @returns index of the next sample to be read, counted from the start of sampling
+ */
+uint32_t XRTLsampler::index() {
+    return readCount;
+}
+
+/**
+ * @brief estimate the time a sample was taken
+ * @param sampleIndex index of the sample, see index()
+ * @returns esp_timer time of the sample in µs
+ * @note based on the completion time of the last DMA buffer and the measured sample rate
+ */
+int64_t XRTLsampler::timestamp(uint32_t sampleIndex) {
+    portENTER_CRITICAL(&timingMux);
+    int64_t blockTime = lastBlockTime;
+    uint32_t blockEnd = lastBlockEnd;
+    portEXIT_CRITICAL(&timingMux);
+
+    if (blockTime == 0) return esp_timer_get_time();
+
+    int32_t distance = (int32_t)(blockEnd - sampleIndex);
+    return blockTime - (int64_t)((double)distance * 1000000.0 / sampleRate());
+}
+
+/**
+ * @returns measured sample rate in Hz
+ * @note the I2S clock dividers can not hit every rate exactly, the configured rate is returned until a measurement is available
+ */
+double XRTLsampler::sampleRate() {
+    portENTER_CRITICAL(&timingMux);
+    int64_t duration = lastBlockTime - firstBlockTime;
+    uint32_t count = lastBlockEnd - firstBlockEnd;
+    portEXIT_CRITICAL(&timingMux);
+
+    if (duration <= 0 || count == 0) return rate;
+    return (double)count * 1000000.0 / (double)duration;
+}
+
+/**
+ * @returns number of times samples were lost because the ring buffer was not drained in time
+ */
+uint32_t XRTLsampler::overflows() {
+    return overflowCount;
+}
+
+/**
+ * @brief convert a raw sample into a calibrated voltage
+ * @param raw sample as delivered by read()
+ * @returns voltage in mV
+ */
+uint32_t XRTLsampler::toMilliVolts(uint16_t raw) {
+    return esp_adc_cal_raw_to_voltage(raw & 0x0FFF, &calibration);
+}
+
+/**
+ * @brief get the ADC channel a raw sample was taken from
+ * @param raw sample as delivered by read()
+ * @returns ADC1 channel number
+ */
+uint8_t XRTLsampler::channelOf(uint16_t raw) {
+    return raw >> 12;
+}
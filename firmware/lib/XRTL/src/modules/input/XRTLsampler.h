@@ -0,0 +1,58 @@
+#ifndef XRTLSAMPLER_H
+#define XRTLSAMPLER_H
+
+#include "common/XRTLfunctions.h"
+#include "driver/adc.h"
+#include "driver/i2s.h"
+#include "esp_adc_cal.h"
+
+#define SAMPLER_BUFFER_SIZE 4096 // samples held by the ring buffer, must be a power of two
+#define SAMPLER_DMA_LENGTH 256   // samples per DMA buffer
+#define SAMPLER_MAX_CHANNELS 8   // ADC1 channels that can be scanned
+
+// continuous sampling of ADC1 pins at a fixed rate, driven by the I2S peripheral and DMA
+// a task copies every completed DMA buffer into a ring buffer, which is drained in the main loop
+// multiple pins are scanned in turn by the pattern table of the ADC, the rate is shared by all pins
+// uses I2S0, which is also needed by the camera: begin() fails unless I2S0 can be claimed via claimI2S()
+class XRTLsampler {
+private:
+    uint32_t rate = 0; // configured sample rate in Hz
+    esp_adc_cal_characteristics_t calibration;
+    TaskHandle_t task = NULL;
+
+    uint16_t ring[SAMPLER_BUFFER_SIZE]; // raw samples as delivered by the ADC (channel in the upper 4 bits)
+    volatile uint32_t writeCount = 0;   // total number of samples written
+    uint32_t readCount = 0;             // total number of samples read
+    uint32_t overflowCount = 0;         // number of times the reader fell behind and samples were lost
+
+    // timing of the DMA buffers, used to measure the actual rate and to timestamp samples
+    volatile int64_t firstBlockTime = 0;
+    volatile uint32_t firstBlockEnd = 0;
+    volatile int64_t lastBlockTime = 0;
+    volatile uint32_t lastBlockEnd = 0;
+    portMUX_TYPE timingMux = portMUX_INITIALIZER_UNLOCKED;
+
+    friend void samplerTask(void *arg);
+
+public:
+    ~XRTLsampler();
+
+    bool begin(uint8_t pin, uint32_t sampleRate);
+    bool begin(const uint8_t *pins, uint8_t pinCount, uint32_t sampleRate);
+    void end();
+
+    uint32_t available();
+    uint32_t read(uint16_t *buffer, uint32_t maxCount);
+    uint32_t index();
+    int64_t timestamp(uint32_t sampleIndex);
+
+    double sampleRate();
+    uint32_t overflows();
+
+    uint32_t toMilliVolts(uint16_t raw);
+    static uint8_t channelOf(uint16_t raw);
+};
+
+void samplerTask(void *arg);
+
+#endif
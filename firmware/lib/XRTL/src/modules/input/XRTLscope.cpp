@@ -0,0 +1,130 @@
+#include "XRTLscope.h"
+#include "XRTLfilter.h"
+
+XRTLscope::~XRTLscope() {
+    free(record);
+}
+
+/**
+ * @brief set record length, pre-trigger part and trigger condition
+ * @param recordLength number of samples per record, constrained to SCOPE_MAX_LENGTH
+ * @param prePercent part of the record before the trigger in %
+ * @param levelMilliVolts trigger level in mV, compared against the unconverted input voltage, constrained to SCOPE_MAX_LEVEL
+ * @param hysteresisMilliVolts the signal must pass the level minus (rising) or plus (falling) this value before a trigger is accepted,
+ * constrained to SCOPE_MAX_LEVEL
+ * @param risingSlope true: trigger on rising edges, false: trigger on falling edges
+ * @returns true if the record buffer could be allocated
+ * @note disarms the scope
+ */
+bool XRTLscope::configure(uint32_t recordLength, uint8_t prePercent, uint16_t levelMilliVolts, uint16_t hysteresisMilliVolts, bool risingSlope) {
+    disarm();
+
+    length = constrain(recordLength, (uint32_t)1, (uint32_t)SCOPE_MAX_LENGTH);
+    preTrigger = min(length * prePercent / 100, length - 1); // at least the trigger sample follows
+    level = min(levelMilliVolts, (uint16_t)SCOPE_MAX_LEVEL) << FILTER_FRACTION;
+    hysteresis = min(hysteresisMilliVolts, (uint16_t)SCOPE_MAX_LEVEL) << FILTER_FRACTION;
+    rising = risingSlope;
+
+    free(record);
+    record = (uint16_t *)(psramFound() ? ps_malloc(length * sizeof(uint16_t)) : malloc(length * sizeof(uint16_t)));
+    if (!record) length = 0;
+    return (record != NULL);
+}
+
+/**
+ * @brief start waiting for the trigger
+ * @note a trigger is only accepted once the pre-trigger part is filled
+ */
+void XRTLscope::arm() {
+    if (!record) return;
+
+    position = 0;
+    filled = 0;
+    ready = false;
+    scopeState = scope_armed;
+}
+
+/**
+ * @brief stop recording, the current record is discarded
+ */
+void XRTLscope::disarm() {
+    scopeState = scope_idle;
+}
+
+/**
+ * @brief feed the next sample
+ * @param sample voltage in mV (Q4)
+ * @param index index of the sample, used to locate the trigger in time
+ */
+void XRTLscope::push(uint16_t sample, uint32_t index) {
+    if (scopeState != scope_armed && scopeState != scope_triggered) return;
+
+    record[position] = sample;
+    if (++position == length) position = 0;
+    filled++;
+
+    if (scopeState == scope_triggered) {
+        if (--remaining == 0) scopeState = scope_complete;
+        return;
+    }
+
+    // armed: the signal has to leave the level by the hysteresis before it can trigger
+    bool edge = false;
+    if (rising) {
+        if (sample + hysteresis < level) ready = true;
+        else if (ready && sample >= level) edge = true;
+    } else {
+        if (sample > level + hysteresis) ready = true;
+        else if (ready && sample <= level) edge = true;
+    }
+    if (!edge) return;
+
+    ready = false;
+    if (filled <= preTrigger) return; // pre-trigger part incomplete, wait for the next edge
+
+    triggerIndex = index;
+    scopeState = scope_triggered;
+    remaining = length - preTrigger - 1; // trigger sample is part of the post-trigger section
+    if (remaining == 0) scopeState = scope_complete;
+}
+
+/**
+ * @returns current state of the scope
+ */
+scopeState_t XRTLscope::state() {
+    return scopeState;
+}
+
+/**
+ * @returns number of samples per record
+ */
+uint32_t XRTLscope::recordLength() {
+    return length;
+}
+
+/**
+ * @returns number of samples recorded before the trigger sample
+ */
+uint32_t XRTLscope::preTriggerLength() {
+    return preTrigger;
+}
+
+/**
+ * @returns sample index of the trigger sample
+ */
+uint32_t XRTLscope::triggerSample() {
+    return triggerIndex;
+}
+
+/**
+ * @brief copy the completed record in chronological order
+ * @param target buffer receiving recordLength() samples in mV (Q4)
+ * @note the trigger sample is located at preTriggerLength()
+ */
+void XRTLscope::read(uint16_t *target) {
+    if (scopeState != scope_complete) return;
+
+    // the ring is full, the oldest sample is located at the write position
+    memcpy(target, record + position, (length - position) * sizeof(uint16_t));
+    memcpy(target + length - position, record, position * sizeof(uint16_t));
+}
@@ -0,0 +1,57 @@
+#ifndef XRTLSCOPE_H
+#define XRTLSCOPE_H
+
+#include "common/XRTLfunctions.h"
+
+#define SCOPE_MAX_LENGTH 8192 // maximum number of samples per record
+#define SCOPE_MAX_LEVEL 3300  // mV, full scale of the input; trigger levels are held in Q4 and would wrap above 4095 mV
+
+enum scopeState_t {
+    scope_idle,      // no record requested
+    scope_armed,     // filling the pre-trigger part, waiting for the trigger
+    scope_triggered, // recording the post-trigger part
+    scope_complete   // record ready to be read
+};
+
+static const char *scopeStateName[4] = {
+    "idle",
+    "armed",
+    "triggered",
+    "complete"
+};
+
+// triggered recording of a continuously sampled input, similar to the single shot mode of an oscilloscope
+// samples are written into a ring buffer until the trigger occurs, the ring then holds the pre-trigger part of the record
+class XRTLscope {
+private:
+    uint16_t *record = NULL; // ring buffer, mV (Q4)
+    uint32_t length = 0;     // samples per record
+    uint32_t preTrigger = 0; // samples recorded before the trigger
+    uint32_t position = 0;   // next position to write
+    uint32_t filled = 0;     // samples written since arming
+    uint32_t remaining = 0;  // post-trigger samples still to be recorded
+
+    uint16_t level = 0;      // trigger level, mV (Q4)
+    uint16_t hysteresis = 0; // distance from the level required before triggering again, mV (Q4)
+    bool rising = true;      // trigger slope
+    bool ready = false;      // signal was on the far side of the level (minus hysteresis)
+
+    uint32_t triggerIndex = 0; // sample index of the trigger
+    scopeState_t scopeState = scope_idle;
+
+public:
+    ~XRTLscope();
+
+    bool configure(uint32_t recordLength, uint8_t prePercent, uint16_t levelMilliVolts, uint16_t hysteresisMilliVolts, bool risingSlope);
+    void arm();
+    void disarm();
+    void push(uint16_t sample, uint32_t index);
+
+    scopeState_t state();
+    uint32_t recordLength();
+    uint32_t preTriggerLength();
+    uint32_t triggerSample();
+    void read(uint16_t *target);
+};
+
+#endif
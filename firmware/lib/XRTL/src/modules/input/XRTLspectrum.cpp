@@ -0,0 +1,260 @@
+#include "XRTLspectrum.h"
+
+XRTLspectrum::~XRTLspectrum() {
+    free(samples);
+    free(work);
+    free(twiddle);
+    free(magnitude);
+}
+
+/**
+ * @brief allocate the buffers and precompute the twiddle factors
+ * @param transformLength number of samples per transform, rounded down to a power of two within SPECTRUM_MIN_LENGTH and SPECTRUM_MAX_LENGTH
+ * @returns true if the buffers could be allocated
+ * @note stops the current recording
+ */
+bool XRTLspectrum::configure(uint32_t transformLength) {
+    recording = false;
+    filled = 0;
+
+    if (transformLength > SPECTRUM_MAX_LENGTH) transformLength = SPECTRUM_MAX_LENGTH;
+    length = SPECTRUM_MIN_LENGTH;
+    while (length * 2 <= transformLength) length *= 2;
+
+    free(samples);
+    free(work);
+    free(twiddle);
+    free(magnitude);
+    samples = (uint16_t *)malloc(length * sizeof(uint16_t));
+    work = (float *)malloc(length * sizeof(float));
+    twiddle = (float *)malloc(length * sizeof(float));
+    magnitude = (float *)malloc((length / 2 + 1) * sizeof(float));
+    if (!samples || !work || !twiddle || !magnitude) {
+        free(samples);
+        free(work);
+        free(twiddle);
+        free(magnitude);
+        samples = NULL;
+        work = NULL;
+        twiddle = NULL;
+        magnitude = NULL;
+        length = 0;
+        return false;
+    }
+
+    for (uint32_t k = 0; k < length / 2; k++) {
+        double phase = 2.0 * M_PI * k / length;
+        twiddle[2 * k] = cos(phase);
+        twiddle[2 * k + 1] = -sin(phase);
+    }
+    memset(magnitude, 0, (length / 2 + 1) * sizeof(float));
+    return true;
+}
+
+/**
+ * @brief start recording the next samples
+ */
+void XRTLspectrum::start() {
+    if (!samples) return;
+
+    filled = 0;
+    recording = true;
+}
+
+/**
+ * @brief feed the next sample
+ * @param sample voltage in mV (Q4)
+ * @param index index of the sample, used to locate the record in time
+ */
+void XRTLspectrum::push(uint16_t sample, uint32_t index) {
+    if (!recording) return;
+
+    if (filled == 0) firstIndex = index;
+    samples[filled++] = sample;
+    if (filled == length) recording = false;
+}
+
+/**
+ * @returns true while samples are recorded
+ */
+bool XRTLspectrum::active() {
+    return recording;
+}
+
+/**
+ * @returns true if a complete record is waiting for compute()
+ */
+bool XRTLspectrum::complete() {
+    return (!recording && length > 0 && filled == length);
+}
+
+/**
+ * @brief transform the recorded samples into the amplitude spectrum
+ * @note the mean is removed before windowing to keep it from leaking into the lowest bins, bin 0 holds the mean instead.
+ * Amplitudes are corrected for the coherent gain of the window: a sine of amplitude A in bin k reads A.
+ */
+void XRTLspectrum::compute() {
+    if (!complete()) return;
+
+    uint64_t sum = 0;
+    for (uint32_t n = 0; n < length; n++) {
+        sum += samples[n];
+    }
+    mean = ((float)sum) / length / (1 << SPECTRUM_FRACTION);
+
+    // pack even samples into the real part, odd samples into the imaginary part
+    // Hann window: 0.5 - 0.5 cos(2 pi n / length), the cosine is taken from the twiddle factors
+    uint32_t half = length / 2;
+    for (uint32_t n = 0; n < length; n++) {
+        float cosine = (n < half) ? twiddle[2 * n] : -twiddle[2 * (n - half)];
+        float sample = ((float)samples[n]) / (1 << SPECTRUM_FRACTION) - mean;
+        work[n] = (0.5 - 0.5 * cosine) * sample;
+    }
+    filled = 0; // record consumed
+
+    transform();
+
+    // split the half length transform Z into the spectrum X of the real input:
+    // X[k] = E[k] + W^k O[k] with E[k] = (Z[k] + Z*[M - k]) / 2, O[k] = (Z[k] - Z*[M - k]) / 2i
+    float scale = 4.0 / length; // single sided amplitude, Hann window sums to length / 2
+    for (uint32_t k = 1; k <= half; k++) {
+        uint32_t a = (k % half) * 2;
+        uint32_t b = ((half - k) % half) * 2;
+        float evenRe = (work[a] + work[b]) / 2;
+        float evenIm = (work[a + 1] - work[b + 1]) / 2;
+        float oddRe = (work[a + 1] + work[b + 1]) / 2;
+        float oddIm = (work[b] - work[a]) / 2;
+
+        float wRe = (k < half) ? twiddle[2 * k] : -1.0;
+        float wIm = (k < half) ? twiddle[2 * k + 1] : 0.0;
+        float re = evenRe + wRe * oddRe - wIm * oddIm;
+        float im = evenIm + wRe * oddIm + wIm * oddRe;
+        magnitude[k] = sqrtf(re * re + im * im) * scale;
+    }
+    magnitude[half] /= 2; // Nyquist bin has no mirror image
+    magnitude[0] = mean;
+}
+
+/**
+ * @brief in-place radix-2 FFT of the length / 2 complex values in work
+ */
+void XRTLspectrum::transform() {
+    uint32_t points = length / 2;
+
+    // bit reversed order
+    for (uint32_t i = 1, j = 0; i < points; i++) {
+        uint32_t bit = points >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i >= j) continue;
+
+        float tmp = work[2 * i];
+        work[2 * i] = work[2 * j];
+        work[2 * j] = tmp;
+        tmp = work[2 * i + 1];
+        work[2 * i + 1] = work[2 * j + 1];
+        work[2 * j + 1] = tmp;
+    }
+
+    // butterflies, the twiddle factors of a stage of size s are exp(-2 pi i j / s) = twiddle[j * length / s]
+    for (uint32_t size = 2; size <= points; size *= 2) {
+        uint32_t span = size / 2;
+        uint32_t stride = length / size;
+        for (uint32_t first = 0; first < points; first += size) {
+            for (uint32_t j = 0; j < span; j++) {
+                float wRe = twiddle[2 * j * stride];
+                float wIm = twiddle[2 * j * stride + 1];
+                float *a = &work[2 * (first + j)];
+                float *b = &work[2 * (first + j + span)];
+
+                float re = wRe * b[0] - wIm * b[1];
+                float im = wRe * b[1] + wIm * b[0];
+                b[0] = a[0] - re;
+                b[1] = a[1] - im;
+                a[0] += re;
+                a[1] += im;
+            }
+        }
+    }
+}
+
+/**
+ * @returns number of samples per transform
+ */
+uint32_t XRTLspectrum::transformLength() {
+    return length;
+}
+
+/**
+ * @returns number of frequency bins, bin k is centered at k * sample rate / transformLength()
+ */
+uint32_t XRTLspectrum::bins() {
+    if (length == 0) return 0;
+    return length / 2 + 1;
+}
+
+/**
+ * @returns amplitudes of the last computed spectrum; mV
+ */
+const float *XRTLspectrum::amplitudes() {
+    return magnitude;
+}
+
+/**
+ * @returns mean voltage of the last computed record; mV
+ */
+float XRTLspectrum::average() {
+    return mean;
+}
+
+/**
+ * @returns sample index of the first sample of the last record
+ */
+uint32_t XRTLspectrum::firstSample() {
+    return firstIndex;
+}
+
+/**
+ * @brief find the strongest local maxima of the last computed spectrum
+ * @param maxPeaks maximum number of peaks, constrained to SPECTRUM_MAX_PEAKS
+ * @param bin receives the interpolated bin of every peak, sorted by descending amplitude
+ * @param amplitude receives the interpolated amplitude of every peak; mV
+ * @returns number of peaks found
+ * @note the peak position is refined by a parabola through the maximum and its neighbors
+ */
+uint8_t XRTLspectrum::peaks(uint8_t maxPeaks, float *bin, float *amplitude) {
+    if (maxPeaks > SPECTRUM_MAX_PEAKS) maxPeaks = SPECTRUM_MAX_PEAKS;
+    uint8_t found = 0;
+
+    for (uint32_t k = 2; k < length / 2; k++) { // bin 1 holds the leakage of the removed mean
+        float left = magnitude[k - 1];
+        float center = magnitude[k];
+        float right = magnitude[k + 1];
+        if (center <= left || center < right) continue;
+
+        float curvature = left - 2 * center + right;
+        float offset = (curvature != 0.0) ? 0.5 * (left - right) / curvature : 0.0;
+        float peak = center - 0.25 * (left - right) * offset;
+
+        // insert into the list sorted by amplitude
+        uint8_t i = found;
+        if (found < maxPeaks) {
+            found++;
+        } else if (peak <= amplitude[maxPeaks - 1]) {
+            continue;
+        } else {
+            i = maxPeaks - 1;
+        }
+        while (i > 0 && amplitude[i - 1] < peak) {
+            amplitude[i] = amplitude[i - 1];
+            bin[i] = bin[i - 1];
+            i--;
+        }
+        amplitude[i] = peak;
+        bin[i] = k + offset;
+    }
+
+    return found;
+}
@@ -0,0 +1,51 @@
+#ifndef XRTLSPECTRUM_H
+#define XRTLSPECTRUM_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPECTRUM_MIN_LENGTH 64   // minimum number of samples per transform
+#define SPECTRUM_MAX_LENGTH 4096 // maximum number of samples per transform, about 2.5 ms of compute time
+#define SPECTRUM_MAX_PEAKS 16    // maximum number of peaks reported
+#define SPECTRUM_FRACTION 4      // samples are fed in mV with 4 fractional bits (Q4), same as FILTER_FRACTION
+
+// amplitude spectrum of a continuously sampled input
+// a fixed number of consecutive samples is recorded, Hann windowed and transformed by a single precision radix-2 FFT.
+// The real input is packed into a complex transform of half the length, which is split into the real spectrum afterwards.
+// Free of Arduino dependencies to allow testing on the host (test/native/test_spectrum).
+class XRTLspectrum {
+private:
+    uint32_t length = 0;      // samples per transform, power of two
+    uint16_t *samples = NULL; // mV (Q4)
+    uint32_t filled = 0;
+    uint32_t firstIndex = 0; // sample index of samples[0]
+    bool recording = false;
+
+    float *work = NULL;      // length / 2 complex values, interleaved real and imaginary part
+    float *twiddle = NULL;   // exp(-2 pi i k / length) for k < length / 2, interleaved
+    float *magnitude = NULL; // length / 2 + 1 amplitudes; mV
+    float mean = 0.0;        // mV
+
+    void transform();
+
+public:
+    ~XRTLspectrum();
+
+    bool configure(uint32_t transformLength);
+    void start();
+    void push(uint16_t sample, uint32_t index);
+    bool active();
+    bool complete();
+    void compute();
+
+    uint32_t transformLength();
+    uint32_t bins();
+    const float *amplitudes();
+    float average();
+    uint32_t firstSample();
+    uint8_t peaks(uint8_t maxPeaks, float *bin, float *amplitude);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "XRTLstatistics.h"
+#include "XRTLfilter.h"
+
+/**
+ * @brief discard all samples and start a new window
+ * @param time start of the window; µs
+ */
+void XRTLstatistics::reset(int64_t time) {
+    count = 0;
+    mean = 0.0;
+    squares = 0.0;
+    minimum = UINT16_MAX;
+    maximum = 0;
+    startTime = time;
+}
+
+/**
+ * @brief add a sample to the window
+ * @param sample voltage in mV (Q4)
+ */
+void XRTLstatistics::push(uint16_t sample) {
+    float x = ((float)sample) / (1 << FILTER_FRACTION);
+    count++;
+    float delta = x - mean;
+    mean += delta / count;
+    squares += delta * (x - mean);
+
+    if (sample < minimum) minimum = sample;
+    if (sample > maximum) maximum = sample;
+}
+
+/**
+ * @returns number of samples in the window
+ */
+uint32_t XRTLstatistics::samples() {
+    return count;
+}
+
+/**
+ * @returns start of the window; µs
+ */
+int64_t XRTLstatistics::start() {
+    return startTime;
+}
+
+/**
+ * @returns mean voltage in mV
+ */
+double XRTLstatistics::average() {
+    return mean;
+}
+
+/**
+ * @returns population variance in mV²
+ */
+double XRTLstatistics::variance() {
+    if (count == 0) return 0.0;
+    return squares / count;
+}
+
+/**
+ * @returns sample standard deviation in mV
+ */
+double XRTLstatistics::deviation() {
+    if (count < 2) return 0.0;
+    return sqrt(squares / (count - 1));
+}
+
+/**
+ * @returns lowest voltage in mV
+ */
+double XRTLstatistics::lowest() {
+    if (count == 0) return 0.0;
+    return ((double)minimum) / (1 << FILTER_FRACTION);
+}
+
+/**
+ * @returns highest voltage in mV
+ */
+double XRTLstatistics::highest() {
+    if (count == 0) return 0.0;
+    return ((double)maximum) / (1 << FILTER_FRACTION);
+}
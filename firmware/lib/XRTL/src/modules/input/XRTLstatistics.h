@@ -0,0 +1,30 @@
+#ifndef XRTLSTATISTICS_H
+#define XRTLSTATISTICS_H
+
+#include "common/XRTLfunctions.h"
+
+// running statistics of the raw samples within a window, updated in a single pass
+// mean and variance follow Welford's method, which stays accurate for long windows in single precision
+class XRTLstatistics {
+private:
+    uint32_t count = 0;
+    float mean = 0.0;     // mV
+    float squares = 0.0;  // sum of squared deviations from the mean; mV²
+    uint16_t minimum = 0; // mV (Q4)
+    uint16_t maximum = 0; // mV (Q4)
+    int64_t startTime = 0;
+
+public:
+    void reset(int64_t time);
+    void push(uint16_t sample);
+
+    uint32_t samples();
+    int64_t start();
+    double average();
+    double variance();
+    double deviation();
+    double lowest();
+    double highest();
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "ConversionChain.h"
+
+ConversionChain::~ConversionChain() {
+    clear();
+}
+
+/**
+ * @returns number of conversions in the chain
+ */
+uint8_t ConversionChain::size() {
+    return conversionCount;
+}
+
+/**
+ * @returns number of stages of the compiled pipeline
+ */
+uint8_t ConversionChain::stages() {
+    return stageCount;
+}
+
+/**
+ * @param index position of the conversion in the chain
+ * @returns pointer to the conversion, NULL if index is out of range
+ */
+InputConverter *ConversionChain::get(uint8_t index) {
+    if (index >= conversionCount) return NULL;
+    return conversion[index];
+}
+
+/**
+ * @brief append a conversion with default settings
+ * @param type type of the conversion
+ * @returns true if the conversion was added
+ * @note call compile() once the chain is complete
+ */
+bool ConversionChain::add(conversion_t type) {
+    if (conversionCount == 16) {
+        Serial.println("WARNING: maximum number of conversions reached");
+        return false;
+    }
+
+    switch (type) {
+    case thermistor: {
+        conversion[conversionCount++] = new Thermistor();
+        return true;
+    }
+
+    case resistance_voltage_divider: {
+        conversion[conversionCount++] = new ResistanceDivider();
+        return true;
+    }
+
+    case voltage_voltage_divider: {
+        conversion[conversionCount++] = new VoltageDivider();
+        return true;
+    }
+
+    case map_value: {
+        conversion[conversionCount++] = new MapValue();
+        return true;
+    }
+
+    case offset: {
+        conversion[conversionCount++] = new Offset();
+        return true;
+    }
+
+    case multiplication: {
+        conversion[conversionCount++] = new Multiplication();
+        return true;
+    }
+    }
+
+    return false;
+}
+
+/**
+ * @brief delete a conversion from the chain
+ * @param index position of the conversion
+ */
+void ConversionChain::remove(uint8_t index) {
+    if (index >= conversionCount) return;
+
+    delete conversion[index];
+    for (int i = index; i < conversionCount - 1; i++) {
+        conversion[i] = conversion[i + 1];
+    }
+    conversion[--conversionCount] = NULL;
+}
+
+/**
+ * @brief exchange the positions of two conversions
+ * @param first position of the first conversion
+ * @param second position of the second conversion
+ */
+void ConversionChain::swap(uint8_t first, uint8_t second) {
+    if (first >= conversionCount || second >= conversionCount || first == second) return;
+
+    InputConverter *tmp = conversion[first];
+    conversion[first] = conversion[second];
+    conversion[second] = tmp;
+}
+
+/**
+ * @brief delete all conversions
+ */
+void ConversionChain::clear() {
+    for (int i = 0; i < conversionCount; i++) {
+        delete conversion[i];
+    }
+    conversionCount = 0;
+    stageCount = 0;
+}
+
+/**
+ * @brief compile the conversions into a minimal pipeline
+ * @note consecutive affine conversions (offset, multiplication, map, voltage divider) are folded into a single multiply-add,
+ * every non-linear conversion gets its own stage. Must be called whenever the conversions change.
+ */
+void ConversionChain::compile() {
+    stageCount = 0;
+    double gain = 1.0;
+    double offset = 0.0;
+
+    for (int i = 0; i < conversionCount; i++) {
+        double stageGain;
+        double stageOffset;
+        if (conversion[i]->isAffine(stageGain, stageOffset)) { // fold: (value * gain + offset) * stageGain + stageOffset
+            gain *= stageGain;
+            offset = offset * stageGain + stageOffset;
+            continue;
+        }
+
+        stage[stageCount++] = {gain, offset, conversion[i]};
+        gain = 1.0;
+        offset = 0.0;
+    }
+
+    if (gain != 1.0 || offset != 0.0) {
+        stage[stageCount++] = {gain, offset, NULL};
+    }
+}
+
+/**
+ * @brief apply the compiled conversion pipeline
+ * @param value value to convert in place
+ */
+void ConversionChain::apply(double &value) {
+    for (int i = 0; i < stageCount; i++) {
+        value = value * stage[i].gain + stage[i].offset;
+        if (stage[i].converter) stage[i].converter->convert(value);
+    }
+}
+
+/**
+ * @brief measure the throughput of the conversions, individually applied and compiled
+ * @param individualRate receives the converted samples per second when applying every conversion
+ * @param compiledRate receives the converted samples per second of the compiled pipeline
+ */
+void ConversionChain::benchmark(double &individualRate, double &compiledRate) {
+    const uint32_t runs = 2000;
+    volatile double result; // keep the compiler from dropping the conversions
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < runs; i++) {
+        double sample = 1000.0 + i % 100;
+        for (int j = 0; j < conversionCount; j++) {
+            conversion[j]->convert(sample);
+        }
+        result = sample;
+    }
+    int64_t individual = max(esp_timer_get_time() - start, (int64_t)1);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < runs; i++) {
+        double sample = 1000.0 + i % 100;
+        apply(sample);
+        result = sample;
+    }
+    int64_t compiled = max(esp_timer_get_time() - start, (int64_t)1);
+
+    individualRate = runs * 1000000.0 / individual;
+    compiledRate = runs * 1000000.0 / compiled;
+}
+
+/**
+ * @brief store the settings of all conversions
+ * @param settings object receiving the array "conversions"
+ * @note nothing is stored if the chain is empty
+ */
+void ConversionChain::save(JsonObject &settings) {
+    if (conversionCount == 0) return;
+
+    JsonArray conversionSettings = settings.createNestedArray("conversions");
+    for (int i = 0; i < conversionCount; i++) {
+        JsonObject saveConversionConfig = conversionSettings.createNestedObject();
+        conversion[i]->saveSettings(saveConversionConfig);
+    }
+}
+
+/**
+ * @brief replace the chain with the conversions stored in settings and compile it
+ * @param settings object containing the array "conversions"
+ * @param debugMode print the settings of every conversion
+ */
+void ConversionChain::load(JsonObject &settings, bool debugMode) {
+    clear();
+
+    JsonArray loadedConversion = settings["conversions"];
+    if (!loadedConversion.isNull()) {
+        for (JsonVariant value : loadedConversion) { // iterate over all objects within loadedConversion
+            JsonObject conversionSettings = value.as<JsonObject>();
+            conversion_t convType = loadValue<conversion_t>("type", conversionSettings, offset);
+            if (!add(convType)) continue;
+            conversion[conversionCount - 1]->loadSettings(conversionSettings, debugMode);
+        }
+    }
+
+    compile();
+}
+
+/**
+ * @brief edit the chain via the Serial interface
+ * @returns false if the user chose to return
+ * @note the chain is compiled after every change
+ */
+bool ConversionChain::dialog() {
+    Serial.println("");
+    Serial.println(centerString("current conversions", 55, ' '));
+    Serial.println("");
+
+    for (int i = 0; i < conversionCount; i++) {
+        Serial.printf("%d: %s\n", i, conversionName[conversion[i]->getType()]);
+    }
+
+    Serial.println("");
+    Serial.println("a: add conversion");
+    Serial.println("d: delete conversion");
+    Serial.println("s: swap conversions");
+    Serial.println("r: return");
+
+    Serial.println("");
+    String choice = serialInput("send single letter or number to edit conversion: ");
+    uint8_t choiceNum = choice.toInt();
+
+    if (choice == "r") {
+        return false;
+    } else if (choice == "a") {
+        Serial.println(centerString("conversions available", 55, ' ').c_str());
+        for (int i = 0; i < 6; i++) {
+            Serial.printf("%d: %s\n", i, conversionName[i]);
+        }
+        Serial.println("");
+
+        conversion_t type = (conversion_t)serialInput("send number to specify type: ").toInt();
+        if (add(type)) {
+            Serial.printf("conversionCount: %d\n", conversionCount);
+            conversion[conversionCount - 1]->setViaSerial();
+        }
+    } else if (choice == "d") {
+        Serial.println("");
+        uint8_t deleteChoice = serialInput("send number to delete conversion: ").toInt();
+        remove(deleteChoice);
+    } else if (choice == "s") {
+        Serial.println("");
+        Serial.println("send the numbers of two conversions to swap");
+
+        String choiceOne = serialInput("first conversion: ");
+        if (choiceOne == "r") return true;
+
+        String choiceTwo = serialInput("second conversion: ");
+        if (choiceTwo == "r") return true;
+
+        swap(choiceOne.toInt(), choiceTwo.toInt());
+    } else if (choiceNum < conversionCount) {
+        conversion[choiceNum]->setViaSerial();
+    }
+
+    compile();
+    return true;
+}
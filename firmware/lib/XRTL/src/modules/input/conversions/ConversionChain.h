@@ -0,0 +1,52 @@
+#ifndef CONVERSIONCHAIN_H
+#define CONVERSIONCHAIN_H
+
+#include "InputConverter.h"
+#include "map/MapValue.h"
+#include "multiply/Multiplication.h"
+#include "offset/Offset.h"
+#include "resdiv/ResistanceDivider.h"
+#include "thermistor/Thermistor.h"
+#include "voltdiv/VoltageDivider.h"
+
+// stage of the compiled conversion pipeline: value * gain + offset, followed by a non-linear conversion if present
+struct conversionStage_t {
+    double gain;
+    double offset;
+    InputConverter *converter; // NULL: affine only
+};
+
+// ordered list of conversions applied to an input value
+// the list is compiled into a minimal pipeline, consecutive affine conversions are folded into a single stage
+class ConversionChain {
+private:
+    // number of conversions currently applied to the input.
+    // maximum number: 16
+    uint8_t conversionCount = 0;
+    InputConverter *conversion[16]; // array that holds the pointers to the individual instances of the conversion class
+
+    uint8_t stageCount = 0;
+    conversionStage_t stage[17];
+
+public:
+    ~ConversionChain();
+
+    uint8_t size();
+    uint8_t stages();
+    InputConverter *get(uint8_t index);
+
+    bool add(conversion_t type);
+    void remove(uint8_t index);
+    void swap(uint8_t first, uint8_t second);
+    void clear();
+
+    void compile();
+    void apply(double &value);
+    void benchmark(double &individualRate, double &compiledRate);
+
+    void save(JsonObject &settings);
+    void load(JsonObject &settings, bool debugMode);
+    bool dialog();
+};
+
+#endif
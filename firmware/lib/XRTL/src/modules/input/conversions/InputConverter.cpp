@@ -2,4 +2,14 @@
 
 conversion_t &InputConverter::getType() {
     return type;
+}
+
+/**
+ * @brief check whether the conversion can be written as value * gain + offset
+ * @param gain receives the factor if the conversion is affine
+ * @param offset receives the offset if the conversion is affine
+ * @returns true if the conversion is affine, consecutive affine conversions can be folded into a single one
+ */
+bool InputConverter::isAffine(double &gain, double &offset) {
+    return false;
 }
\ No newline at end of file
@@ -32,6 +32,7 @@ protected:
 public:
     ParameterPack parameters;
     virtual void convert(double &value){};
+    virtual bool isAffine(double &gain, double &offset);
     conversion_t &getType();
 
     // handle settings
@@ -27,4 +27,10 @@ void MapValue::setViaSerial() {
 
 void MapValue::convert(double &value) {
     value = (value - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+bool MapValue::isAffine(double &gain, double &offset) {
+    gain = (outMax - outMin) / (inMax - inMin);
+    offset = outMin - inMin * gain;
+    return true;
 }
\ No newline at end of file
@@ -24,4 +24,10 @@ void Multiplication::setViaSerial() {
 
 void Multiplication::convert(double &value) {
     value = value * multiplicator;
+}
+
+bool Multiplication::isAffine(double &gain, double &offset) {
+    gain = multiplicator;
+    offset = 0.0;
+    return true;
 }
\ No newline at end of file
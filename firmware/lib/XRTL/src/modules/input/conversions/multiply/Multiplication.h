@@ -19,6 +19,7 @@ public:
     void setViaSerial();
 
     void convert(double &value);
+    bool isAffine(double &gain, double &offset);
 };
 
 #endif
\ No newline at end of file
@@ -24,4 +24,10 @@ void Offset::loadSettings(JsonObject &settings, bool debugMode) {
 
 void Offset::convert(double &value) {
     value = value + offsetValue;
+}
+
+bool Offset::isAffine(double &gain, double &offset) {
+    gain = 1.0;
+    offset = offsetValue;
+    return true;
 }
\ No newline at end of file
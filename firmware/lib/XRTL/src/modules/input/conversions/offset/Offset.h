@@ -19,6 +19,7 @@ public:
     void loadSettings(JsonObject &settings, bool debugMode);
 
     void convert(double &value);
+    bool isAffine(double &gain, double &offset);
 };
 
 #endif
\ No newline at end of file
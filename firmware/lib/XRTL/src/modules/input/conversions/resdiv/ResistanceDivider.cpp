@@ -24,5 +24,6 @@ void ResistanceDivider::setViaSerial() {
 }
 
 void ResistanceDivider::convert(double &value) {
-    value = refResistor * value / (refVoltage - value);
+    float voltage = value; // single precision: the ESP32 has no double precision FPU
+    value = (float)refResistor * voltage / ((float)refVoltage - voltage);
 }
\ No newline at end of file
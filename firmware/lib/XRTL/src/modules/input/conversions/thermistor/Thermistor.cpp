@@ -18,12 +18,14 @@ void Thermistor::loadSettings(JsonObject &settings, bool debugMode) {
     parameters.load(settings);
     if (debugMode)
         parameters.print();
+    table.build(tempNormal, resNormal, beta);
 }
 
 void Thermistor::setViaSerial() {
     parameters.setViaSerial();
+    table.build(tempNormal, resNormal, beta);
 }
 
 void Thermistor::convert(double &value) {
-    value = 1 / (log(value / resNormal) / beta + (1 / tempNormal));
+    value = table.convert(value);
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 #define THERMISTORCONV_H
 
 #include "modules/input/conversions/InputConverter.h"
+#include "ThermistorTable.h"
 
 // convert a resistance into temperature by use of an NTC
+// the conversion is evaluated via an interpolated lookup table (ThermistorTable), built when the settings change
 class Thermistor : public InputConverter {
 private:
     // Temperature at which the normal resistance was measured.
@@ -18,6 +20,8 @@ private:
     // Example: tempNormal = 298.15 K, beta = 3750 K
     double beta;
 
+    ThermistorTable table;
+
 public:
     Thermistor();
 
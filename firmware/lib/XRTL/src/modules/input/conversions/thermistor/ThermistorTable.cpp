@@ -0,0 +1,55 @@
+#include "ThermistorTable.h"
+
+/**
+ * @brief tabulate the temperature over the resistance range of the table
+ * @param temperature temperature at which the normal resistance was measured, relative to absolute zero
+ * @param resistance normal resistance of the NTC
+ * @param betaValue beta value of the NTC, same unit as the temperature
+ * @returns false if the values do not describe an NTC, every conversion uses the exact formula then
+ * @note nodes are spaced linearly within each octave, which matches the bit layout of a float and makes indexing free
+ */
+bool ThermistorTable::build(double temperature, double resistance, double betaValue) {
+    tempNormal = temperature;
+    resNormal = resistance;
+    beta = betaValue;
+    valid = (resNormal > 0 && beta != 0 && tempNormal != 0);
+    if (!valid) return false;
+
+    inverseNormal = 1.0 / resNormal;
+    uint32_t segments = 1 << THERMISTOR_SEGMENT_BITS;
+    for (uint32_t i = 0; i <= (THERMISTOR_OCTAVES << THERMISTOR_SEGMENT_BITS); i++) {
+        double ratio = ldexp(1.0 + (double)(i % segments) / segments, (int)(i >> THERMISTOR_SEGMENT_BITS) - THERMISTOR_OCTAVES / 2);
+        table[i] = exact(ratio * resNormal);
+    }
+    return true;
+}
+
+/**
+ * @brief convert a resistance by the analytic formula
+ * @param value resistance, same unit as resNormal
+ * @returns temperature, same unit as tempNormal
+ */
+double ThermistorTable::exact(double value) {
+    return 1 / (log(value / resNormal) / beta + (1 / tempNormal));
+}
+
+/**
+ * @brief convert a resistance by interpolation in the table
+ * @param value resistance, same unit as resNormal
+ * @returns temperature, same unit as tempNormal
+ */
+double ThermistorTable::convert(double value) {
+    if (!valid) return exact(value);
+
+    float ratio = (float)value * inverseNormal;
+    uint32_t bits;
+    memcpy(&bits, &ratio, sizeof(bits));
+
+    // exponent selects the octave, the upper mantissa bits the segment (negative values end up out of range via the sign bit)
+    int32_t octave = (int32_t)(bits >> 23) - 127 + THERMISTOR_OCTAVES / 2;
+    if (octave < 0 || octave >= THERMISTOR_OCTAVES) return exact(value);
+
+    uint32_t index = (octave << THERMISTOR_SEGMENT_BITS) | ((bits >> (23 - THERMISTOR_SEGMENT_BITS)) & ((1 << THERMISTOR_SEGMENT_BITS) - 1));
+    float fraction = (bits & ((1 << (23 - THERMISTOR_SEGMENT_BITS)) - 1)) * (1.0f / (1 << (23 - THERMISTOR_SEGMENT_BITS)));
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
@@ -0,0 +1,32 @@
+#ifndef THERMISTORTABLE_H
+#define THERMISTORTABLE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define THERMISTOR_OCTAVES 16 // table covers resNormal / 2^8 to resNormal * 2^8
+#define THERMISTOR_SEGMENT_BITS 5 // 32 segments per octave
+
+// temperature of an NTC over its resistance, evaluated via an interpolated lookup table in single precision
+// maximum error: T² (1 + 2T / beta) / (8192 beta), e.g. 10 mK at 240 °C for beta = 3950 K, below 1 mK near tempNormal
+// resistances outside the table are converted by the exact formula
+// Free of Arduino dependencies to allow testing on the host (test/native/test_thermistor).
+class ThermistorTable {
+private:
+    double tempNormal = 0.0;
+    double resNormal = 0.0;
+    double beta = 0.0;
+
+    float table[(THERMISTOR_OCTAVES << THERMISTOR_SEGMENT_BITS) + 1]; // temperature at resNormal * 2^(octave - 8) * (1 + segment / 32)
+    float inverseNormal = 0.0; // 1 / resNormal
+    bool valid = false;
+
+public:
+    bool build(double temperature, double resistance, double betaValue);
+
+    double exact(double value);
+    double convert(double value);
+};
+
+#endif
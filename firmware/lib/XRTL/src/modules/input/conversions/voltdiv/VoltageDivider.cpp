@@ -1,7 +1,7 @@
 #include "VoltageDivider.h"
 
 VoltageDivider::VoltageDivider() {
-    type = resistance_voltage_divider;
+    type = voltage_voltage_divider;
 
     parameters.setKey("");
     parameters.add(type, "type");
@@ -24,4 +24,10 @@ void VoltageDivider::setViaSerial() {
 
 void VoltageDivider::convert(double &value) {
     value = (refOne + refTwo) / refTwo * value;
+}
+
+bool VoltageDivider::isAffine(double &gain, double &offset) {
+    gain = (refOne + refTwo) / refTwo;
+    offset = 0.0;
+    return true;
 }
\ No newline at end of file
@@ -21,6 +21,11 @@ MacroModule::~MacroModule()
     }
 }
 
+moduleType MacroModule::getType()
+{
+    return type;
+}
+
 void MacroModule::setup()
 {
     if (!initState || initState == "" || stateCount == 0)
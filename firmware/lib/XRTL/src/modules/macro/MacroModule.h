@@ -32,6 +32,7 @@ public:
     ~MacroModule();
 
     moduleType type = xrtl_macro;
+    moduleType getType();
     ParameterPack stateParameters;
 
     void setup();
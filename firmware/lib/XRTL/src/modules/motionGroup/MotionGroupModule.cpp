@@ -0,0 +1,241 @@
+#include "MotionGroupModule.h"
+
+MotionGroupModule::MotionGroupModule(String moduleName) {
+    id = moduleName;
+
+    parameters.setKey(id);
+    parameters.add(type, "type");
+    parameters.add(axisId[0], "axis1", "String");
+    parameters.add(axisId[1], "axis2", "String");
+    parameters.add(axisId[2], "axis3", "String");
+    parameters.add(axisId[3], "axis4", "String");
+    parameters.add(accel, "accel", "steps/s²");
+    parameters.add(speed, "speed", "steps/s");
+    parameters.add(deviation, "deviation", "steps");
+}
+
+moduleType MotionGroupModule::getType() {
+    return type;
+}
+
+void MotionGroupModule::setup() {
+    if (!interpolator.begin()) {
+        debug("WARNING: unable to create step timer");
+    }
+    interpolator.setMaxSpeed(speed);
+    interpolator.setAcceleration(accel);
+    interpolator.setDeviation(deviation);
+
+    if (!connect()) debug("no axes available");
+}
+
+/**
+ * @brief locate the steppers of the group
+ * @returns true if at least one stepper was found
+ * @note the motors are handed to the interpolator with every move: they are created during the setup of the steppers
+ */
+bool MotionGroupModule::connect() {
+    axisCount = 0;
+    for (uint8_t i = 0; i < INTERPOLATOR_MAX_AXES; i++) {
+        if (axisId[i] == "") continue;
+
+        XRTLmodule *candidate = findModule(axisId[i]);
+        if (candidate && candidate->getType() == xrtl_stepper) {
+            axis[axisCount++] = static_cast<StepperModule *>(candidate);
+        } else {
+            debug("WARNING: <%s> is no stepper module", axisId[i].c_str());
+        }
+    }
+
+    return (axisCount > 0);
+}
+
+void MotionGroupModule::loop() {
+    if (!running) return;
+    if (interpolator.isRunning()) return; // steps are generated by the timer
+
+    for (uint8_t i = 0; i < axisCount; i++) {
+        XRTLmotor *motor = axis[i]->motor();
+        if (motor) motor->release(); // the steppers finish their grouped operation in their next loop
+    }
+    running = false;
+    debug("move complete");
+    sendStatus();
+    notify(ready);
+}
+
+/**
+ * @brief decelerate all axes to a stop on the path, queued moves are discarded
+ * @note returns immediately
+ */
+void MotionGroupModule::stop() {
+    if (!running) return;
+
+    interpolator.stop();
+    debug("stopping");
+}
+
+void MotionGroupModule::saveSettings(JsonObject &settings) {
+    parameters.save(settings);
+}
+
+void MotionGroupModule::loadSettings(JsonObject &settings) {
+    parameters.load(settings);
+    if (debugging && *debugging) parameters.print();
+}
+
+void MotionGroupModule::setViaSerial() {
+    parameters.setViaSerial();
+}
+
+bool MotionGroupModule::getStatus(JsonObject &status) {
+    status["busy"] = running;
+    status["planner"] = plannerStateName[interpolator.state()];
+    status["queued"] = interpolator.queued();
+
+    long target[INTERPOLATOR_MAX_AXES];
+    if (running) interpolator.plannedPosition(target);
+
+    JsonArray position = status.createNestedArray("position");
+    JsonArray targets = status.createNestedArray("target");
+    for (uint8_t i = 0; i < axisCount; i++) {
+        XRTLmotor *motor = axis[i]->motor();
+        long current = motor ? motor->currentPosition() : 0;
+        position.add(current);
+        targets.add(running ? target[i] : current);
+    }
+
+    status["stepJitter"] = interpolator.meanJitter();
+    status["maxStepJitter"] = interpolator.peakJitter();
+    return true;
+}
+
+/**
+ * @brief queue a straight move of all axes
+ * @param values one target per axis in the order of the settings, null: keep the axis in place
+ * @param relative true: the values are distances from the end of the queued moves, false: absolute positions
+ */
+void MotionGroupModule::moveGroup(JsonArray &values, bool relative) {
+    XRTLmotor *motor[INTERPOLATOR_MAX_AXES];
+    for (uint8_t i = 0; i < axisCount; i++) {
+        motor[i] = axis[i]->motor();
+        if (motor[i]) continue;
+
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] stepper <";
+        errmsg += axisId[i];
+        errmsg += "> not ready";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    if (interpolator.queued() == INTERPOLATOR_QUEUE_LENGTH) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] command rejected: queue full";
+        sendError(is_busy, errmsg);
+        return;
+    }
+
+    if (!running) { // first move: take over the steppers
+        for (uint8_t i = 0; i < axisCount; i++) {
+            if (axis[i]->joinGroup()) continue;
+
+            for (uint8_t j = 0; j < i; j++) {
+                motor[j]->release(); // the steppers finish their grouped operation in their next loop
+            }
+
+            String errmsg = "[";
+            errmsg += id;
+            errmsg += "] command rejected: stepper <";
+            errmsg += axis[i]->getID();
+            errmsg += "> already moving";
+            sendError(is_busy, errmsg);
+            return;
+        }
+        interpolator.setAxes(motor, axisCount);
+    }
+
+    long target[INTERPOLATOR_MAX_AXES];
+    interpolator.plannedPosition(target);
+    for (uint8_t i = 0; i < axisCount; i++) {
+        if (i >= values.size() || !values[i].is<long>()) continue;
+
+        long value = values[i].as<long>();
+        target[i] = relative ? target[i] + value : value;
+
+        long lower = axis[i]->lowerLimit();
+        long upper = axis[i]->upperLimit();
+        if (target[i] >= lower && target[i] <= upper) continue;
+
+        target[i] = constrain(target[i], lower, upper);
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] target of axis ";
+        errmsg += i + 1;
+        errmsg += " was constrained to (";
+        errmsg += lower;
+        errmsg += ",";
+        errmsg += upper;
+        errmsg += ")";
+        sendError(out_of_bounds, errmsg);
+    }
+
+    if (!interpolator.add(target)) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] command rejected: group is stopping";
+        sendError(is_busy, errmsg);
+    }
+
+    if (!running) {
+        running = true; // released by loop(), even if nothing was queued
+        debug("moving %d axes", axisCount);
+        notify(busy);
+    }
+    sendStatus();
+}
+
+void MotionGroupModule::handleCommand(String &controlId, JsonObject &command) {
+    if (!isModule(controlId) && controlId != "*") return;
+
+    bool temp = false;
+    if (getValue<bool>("getStatus", command, temp) && temp) {
+        sendStatus();
+    }
+
+    if (getValue<bool>("stop", command, temp) && temp) {
+        stop();
+        sendStatus();
+    }
+
+    bool speedChanged = getAndConstrainValue<uint16_t>("speed", command, speed, 1, 65535);
+    bool accelChanged = getAndConstrainValue<uint16_t>("accel", command, accel, 1, 65535);
+    bool deviationChanged = getAndConstrainValue<double>("deviation", command, deviation, 0.0, 1000.0);
+    if (speedChanged) interpolator.setMaxSpeed(speed);
+    if (accelChanged) interpolator.setAcceleration(accel);
+    if (deviationChanged) interpolator.setDeviation(deviation);
+
+    JsonArray values;
+    bool relative = false;
+    if (command["moveTo"].is<JsonArray>()) {
+        values = command["moveTo"].as<JsonArray>();
+    } else if (command["move"].is<JsonArray>()) {
+        values = command["move"].as<JsonArray>();
+        relative = true;
+    } else {
+        if (speedChanged || accelChanged || deviationChanged) sendStatus();
+        return;
+    }
+
+    if (axisCount == 0) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] no axes available, check settings";
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    moveGroup(values, relative);
+}
@@ -0,0 +1,43 @@
+#ifndef MOTIONGROUPMODULE_H
+#define MOTIONGROUPMODULE_H
+
+#include "XRTLinterpolator.h"
+#include "modules/stepper/StepperModule.h"
+
+// moves several local steppers on straight lines, all axes start and finish together
+// the steps of all axes are generated by a single timer, the steppers report as grouped while the moves run
+// moves are queued and blended: consecutive segments are passed without stopping in between
+class MotionGroupModule : public XRTLmodule {
+private:
+    String axisId[INTERPOLATOR_MAX_AXES] = {"", "", "", ""}; // controlIds of the StepperModules, empty: unused
+    uint16_t accel = 500;                                    // along the path; steps/s²
+    uint16_t speed = 500;                                    // along the path; steps/s
+    double deviation = 5.0;                                  // junction deviation: distance at which corners are passed; steps
+
+    XRTLinterpolator interpolator;
+    StepperModule *axis[INTERPOLATOR_MAX_AXES];
+    uint8_t axisCount = 0;
+
+    bool running = false; // steppers are claimed by the group
+
+    bool connect();
+    void moveGroup(JsonArray &values, bool relative);
+
+public:
+    MotionGroupModule(String moduleName);
+    moduleType type = xrtl_motionGroup;
+    moduleType getType();
+
+    void setup();
+    void loop();
+    void stop();
+
+    void saveSettings(JsonObject &settings);
+    void loadSettings(JsonObject &settings);
+    void setViaSerial();
+    bool getStatus(JsonObject &status);
+
+    void handleCommand(String &controlId, JsonObject &command);
+};
+
+#endif
@@ -0,0 +1,469 @@
+#include "XRTLinterpolator.h"
+
+XRTLinterpolator::~XRTLinterpolator() {
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+    }
+    if (pulseTimer) {
+        esp_timer_stop(pulseTimer);
+        esp_timer_delete(pulseTimer);
+    }
+}
+
+/**
+ * @brief create the step timer and the timer ending the step pulses
+ * @returns true if the timers could be created
+ */
+bool XRTLinterpolator::begin() {
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = interpolatorTimer;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "motion group";
+    if (esp_timer_create(&timerArgs, &timer) != ESP_OK) return false;
+
+    timerArgs.callback = interpolatorPulse;
+    timerArgs.name = "motion group pulse";
+    return (esp_timer_create(&timerArgs, &pulseTimer) == ESP_OK);
+}
+
+/**
+ * @brief select the motors moved together
+ * @param motors list of motors, the order defines the order of the targets
+ * @param motorCount number of motors, constrained to INTERPOLATOR_MAX_AXES
+ * @returns false while a move is running
+ */
+bool XRTLinterpolator::setAxes(XRTLmotor **motors, uint8_t motorCount) {
+    if (isRunning()) return false;
+
+    axisCount = min(motorCount, (uint8_t)INTERPOLATOR_MAX_AXES);
+    for (uint8_t i = 0; i < axisCount; i++) {
+        axis[i] = motors[i];
+    }
+    return true;
+}
+
+/**
+ * @param pathSpeed maximum speed along the path; steps/s
+ * @note the limit applies immediately, junction speeds of queued moves are kept
+ */
+void XRTLinterpolator::setMaxSpeed(float pathSpeed) {
+    speed = max(pathSpeed, 1.0f);
+}
+
+/**
+ * @param pathAcceleration acceleration along the path; steps/s²
+ * @note the limit applies immediately, junction speeds of queued moves are kept
+ */
+void XRTLinterpolator::setAcceleration(float pathAcceleration) {
+    acceleration = max(pathAcceleration, 1.0f);
+}
+
+/**
+ * @param junctionDeviation permitted distance between the path and the corner at a junction; steps
+ * @note larger values pass corners faster, 0 stops at every corner
+ */
+void XRTLinterpolator::setDeviation(float junctionDeviation) {
+    portENTER_CRITICAL(&groupMux);
+    deviation = max(junctionDeviation, 0.0f);
+    portEXIT_CRITICAL(&groupMux);
+}
+
+/**
+ * @brief queue a straight move of all axes
+ * @param targets absolute target position of every axis in steps
+ * @returns false if no timer is available, the queue is full or the group is stopping
+ * @note all axes must be claimed before the first move is queued
+ */
+bool XRTLinterpolator::add(const long *targets) {
+    if (!timer || axisCount == 0) return false;
+
+    portENTER_CRITICAL(&groupMux);
+    if (halting || count == INTERPOLATOR_QUEUE_LENGTH) {
+        portEXIT_CRITICAL(&groupMux);
+        return false;
+    }
+
+    if (count == 0) {
+        for (uint8_t i = 0; i < axisCount; i++) {
+            planned[i] = axis[i]->currentPosition();
+        }
+    }
+
+    segment_t &segment = queue[(head + count) % INTERPOLATOR_QUEUE_LENGTH];
+    segment.length = 0;
+    float path = 0.0f;
+    for (uint8_t i = 0; i < axisCount; i++) {
+        long distance = targets[i] - planned[i];
+        segment.target[i] = targets[i];
+        segment.forward[i] = (distance >= 0);
+        segment.delta[i] = labs(distance);
+        segment.length = max(segment.length, segment.delta[i]);
+        segment.unit[i] = distance;
+        path += (float)distance * (float)distance;
+    }
+
+    if (segment.length == 0) {
+        portEXIT_CRITICAL(&groupMux);
+        return true;
+    }
+
+    segment.end = segment.length;
+    segment.pathLength = sqrtf(path);
+    segment.ratio = segment.length / segment.pathLength; // the major axis steps on every call
+    for (uint8_t i = 0; i < axisCount; i++) {
+        segment.unit[i] /= segment.pathLength;
+    }
+
+    segment.maxEntry = 0.0f; // a new run starts from rest
+    if (count > 0) {
+        // junction deviation: the corner is passed on an arc that keeps within the deviation of the corner,
+        // at the speed at which the centripetal acceleration equals the acceleration
+        segment_t &previous = queue[(head + count - 1) % INTERPOLATOR_QUEUE_LENGTH];
+        float cosTheta = 0.0f;
+        for (uint8_t i = 0; i < axisCount; i++) {
+            cosTheta -= previous.unit[i] * segment.unit[i];
+        }
+
+        if (cosTheta < -0.999f) { // straight on
+            segment.maxEntry = speed;
+        } else if (cosTheta < 0.999f) { // anything but a reversal
+            float sinHalfTheta = sqrtf(0.5f * (1.0f - cosTheta));
+            segment.maxEntry = min(speed, sqrtf(acceleration * deviation * sinHalfTheta / (1.0f - sinHalfTheta)));
+        }
+    }
+    segment.entry = segment.maxEntry;
+    segment.exit = 0.0f;
+
+    for (uint8_t i = 0; i < axisCount; i++) {
+        planned[i] = targets[i];
+    }
+    count++;
+
+    bool start = !timerActive;
+    if (start) {
+        startSegment();
+        aimed = false; // the direction pins are unknown after other moves
+        rate = 0.0f;
+        nextStep = 0;
+        lastJitter = 0;
+        maxJitter = 0;
+        jitterSum = 0;
+        jitterCount = 0;
+        timerActive = true;
+    }
+    recalculate();
+    portEXIT_CRITICAL(&groupMux);
+
+    if (start) esp_timer_start_once(timer, MOTOR_MIN_DELAY);
+    return true;
+}
+
+/**
+ * @brief plan the speeds at the junctions of all queued segments
+ * @note the group must be locked
+ */
+void XRTLinterpolator::recalculate() {
+    if (count == 0) return;
+
+    // backward pass: the last segment ends at rest, every segment must be able to brake to the entry of its successor
+    float next = 0.0f;
+    for (uint8_t i = count - 1; i > 0; i--) {
+        segment_t &segment = queue[(head + i) % INTERPOLATOR_QUEUE_LENGTH];
+        segment.exit = next;
+        segment.entry = min(segment.maxEntry, sqrtf(next * next + 2.0f * acceleration * segment.pathLength));
+        next = segment.entry;
+    }
+
+    // forward pass: every segment can only reach what its entry speed and length permit, starting with the one being executed
+    segment_t &current = queue[head];
+    float currentSpeed = rate / current.ratio;
+    float remaining = (end - done) / current.ratio;
+    current.exit = min(next, sqrtf(currentSpeed * currentSpeed + 2.0f * acceleration * remaining));
+
+    float previous = current.exit;
+    for (uint8_t i = 1; i < count; i++) {
+        segment_t &segment = queue[(head + i) % INTERPOLATOR_QUEUE_LENGTH];
+        segment.entry = min(segment.entry, previous);
+        segment.exit = min(segment.exit, sqrtf(segment.entry * segment.entry + 2.0f * acceleration * segment.pathLength));
+        previous = segment.exit;
+    }
+}
+
+/**
+ * @brief prepare the execution of the first queued segment
+ * @note the group must be locked
+ */
+void XRTLinterpolator::startSegment() {
+    segment_t &segment = queue[head];
+    for (uint8_t i = 0; i < axisCount; i++) {
+        error[i] = segment.length / 2; // centers the steps of the minor axes within the major steps
+    }
+    end = segment.end;
+    done = 0;
+
+    aimed = true; // a change of direction is set one timer call ahead of the first step
+    for (uint8_t i = 0; i < axisCount; i++) {
+        if (segment.delta[i] > 0 && segment.forward[i] != direction[i]) aimed = false;
+    }
+}
+
+/**
+ * @brief timer callback, forwards to the interpolator
+ * @param arg pointer to the XRTLinterpolator
+ */
+void interpolatorTimer(void *arg) {
+    ((XRTLinterpolator *)arg)->tick();
+}
+
+/**
+ * @brief pulse timer callback, forwards to the interpolator
+ * @param arg pointer to the XRTLinterpolator
+ */
+void interpolatorPulse(void *arg) {
+    XRTLinterpolator *interpolator = (XRTLinterpolator *)arg;
+    portENTER_CRITICAL(&interpolator->groupMux);
+    interpolator->endPulses();
+    portEXIT_CRITICAL(&interpolator->groupMux);
+}
+
+/**
+ * @brief end the step pulses of all axes
+ * @note the group must be locked
+ */
+void XRTLinterpolator::endPulses() {
+    for (uint8_t i = 0; i < axisCount; i++) {
+        axis[i]->endStep();
+    }
+}
+
+/**
+ * @brief step the major axis, the minor axes as far as due, and schedule the next step
+ * @note runs in the esp_timer task. Step pulses are not timed by waiting: they are ended by the pulse timer,
+ * and the directions of a segment are set one timer call ahead of its first step.
+ */
+void XRTLinterpolator::tick() {
+    portENTER_CRITICAL(&groupMux);
+    endPulses(); // usually done by the pulse timer already
+    if (!timerActive) {
+        portEXIT_CRITICAL(&groupMux);
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (nextStep != 0 && now >= nextStep) {
+        lastJitter = now - nextStep;
+        maxJitter = max(maxJitter, lastJitter);
+        jitterSum += lastJitter;
+        jitterCount++;
+    }
+
+    for (uint8_t i = 0; i < axisCount; i++) {
+        if (axis[i]->stopRequested()) halt(); // a single axis was told to stop: the whole group stops on its path
+    }
+
+    segment_t &segment = queue[head];
+    if (!aimed) { // the first step follows after the setup time of the drivers
+        for (uint8_t i = 0; i < axisCount; i++) {
+            if (segment.delta[i] == 0) continue;
+            axis[i]->prepareStep(segment.forward[i]);
+            direction[i] = segment.forward[i];
+        }
+        aimed = true;
+        uint32_t wait = schedule(now, MOTOR_MIN_DELAY);
+        portEXIT_CRITICAL(&groupMux);
+
+        esp_timer_start_once(timer, wait);
+        return;
+    }
+
+    bool stepped = false;
+    if (done < end) {
+        for (uint8_t i = 0; i < axisCount; i++) {
+            error[i] += segment.delta[i];
+            if (error[i] < segment.length) continue;
+
+            error[i] -= segment.length;
+            axis[i]->step(segment.forward[i]);
+            stepped = true;
+        }
+        done++;
+    }
+
+    if (done >= end) {
+        float pathSpeed = rate / segment.ratio;
+        head = (head + 1) % INTERPOLATOR_QUEUE_LENGTH;
+        count--;
+
+        if (count == 0) {
+            timerActive = false;
+            halting = false;
+            plannerState = planner_idle;
+            rate = 0.0f;
+            nextStep = 0;
+            portEXIT_CRITICAL(&groupMux);
+
+            if (stepped) esp_timer_start_once(pulseTimer, MOTOR_MIN_DELAY);
+            return;
+        }
+
+        startSegment(); // continue at the junction speed
+        rate = pathSpeed * queue[head].ratio;
+    }
+
+    uint32_t wait = schedule(now, interval());
+    portEXIT_CRITICAL(&groupMux);
+
+    if (stepped) esp_timer_start_once(pulseTimer, MOTOR_MIN_DELAY); // pulse width, fails harmlessly if a pulse is pending
+    esp_timer_start_once(timer, wait);
+}
+
+/**
+ * @brief advance the deadline of the next step
+ * @param now time of the current call; µs
+ * @param delay interval between the current and the next step; µs
+ * @returns time left until the deadline, at least MOTOR_MIN_DELAY; µs
+ * @note schedules from the deadline, not from the late call: latencies must not add up along the path.
+ * If even the next deadline is already missed, e.g. after a blocked timer task, the schedule restarts instead of bursting.
+ * The group must be locked.
+ */
+uint32_t XRTLinterpolator::schedule(int64_t now, uint32_t delay) {
+    nextStep = (nextStep != 0 && nextStep + delay > now) ? nextStep + delay : now + delay;
+    int64_t wait = nextStep - esp_timer_get_time();
+    return max(wait, (int64_t)MOTOR_MIN_DELAY);
+}
+
+/**
+ * @brief select the speed for the next step of the major axis
+ * @returns interval in µs
+ * @note v² = v0² + 2as: accelerate from the current speed, brake towards the exit speed of the segment
+ */
+uint32_t XRTLinterpolator::interval() {
+    segment_t &segment = queue[head];
+    float maxRate = speed * segment.ratio;
+    float rateAcceleration = acceleration * segment.ratio;
+    float exitRate = segment.exit * segment.ratio; // brakes to 0 at the stop point while halting
+
+    float accelerated = sqrtf(rate * rate + 2.0f * rateAcceleration);
+    float braking = sqrtf(exitRate * exitRate + 2.0f * rateAcceleration * (end - done));
+
+    if (braking < min(maxRate, accelerated)) {
+        rate = braking;
+        plannerState = halting ? planner_stopping : planner_decelerating;
+    } else if (accelerated < maxRate) {
+        rate = accelerated;
+        plannerState = planner_accelerating;
+    } else {
+        rate = maxRate;
+        plannerState = planner_cruising;
+    }
+
+    return (uint32_t)(1000000.0f / rate);
+}
+
+/**
+ * @brief keep the segments needed to brake, shorten the last of them and discard the rest of the queue
+ * @note the group must be locked. The braking distance v²/2a along the path may reach across several segments:
+ * their exit speeds are lowered to brake to a standstill at the stop point. The planned position becomes the stop point.
+ */
+void XRTLinterpolator::halt() {
+    if (count == 0 || halting) return;
+
+    // walk along the queue until the braking distance is covered
+    float pathSpeed = rate / queue[head].ratio;
+    float brake = pathSpeed * pathSpeed / (2.0f * acceleration);
+    float available = (end - done) / queue[head].ratio;
+    uint8_t kept = 0;
+    while (brake > available && kept + 1 < count) {
+        brake -= available;
+        kept++;
+        available = queue[(head + kept) % INTERPOLATOR_QUEUE_LENGTH].pathLength;
+    }
+
+    segment_t &last = queue[(head + kept) % INTERPOLATOR_QUEUE_LENGTH];
+    uint32_t stop = (kept == 0 ? done : 0) + (uint32_t)ceilf(brake * last.ratio);
+    last.end = min(last.end, stop);
+    if (kept == 0) end = min(end, stop);
+
+    // exit speeds permitting a standstill at the stop point, the head brakes in interval()
+    float remaining = 0.0f;
+    last.exit = 0.0f;
+    for (uint8_t i = kept; i > 0; i--) {
+        segment_t &following = queue[(head + i) % INTERPOLATOR_QUEUE_LENGTH];
+        segment_t &segment = queue[(head + i - 1) % INTERPOLATOR_QUEUE_LENGTH];
+        remaining += following.end / following.ratio;
+        segment.exit = min(segment.exit, sqrtf(2.0f * acceleration * remaining));
+    }
+
+    // the accumulators start at length / 2: after n major steps an axis performed (length / 2 + n * delta) / length steps
+    uint32_t lastEnd = (kept == 0) ? end : last.end;
+    for (uint8_t i = 0; i < axisCount; i++) {
+        long skipped = last.delta[i] - (last.length / 2 + (uint64_t)lastEnd * last.delta[i]) / last.length;
+        planned[i] = last.forward[i] ? last.target[i] - skipped : last.target[i] + skipped;
+    }
+    count = kept + 1;
+    halting = true;
+    plannerState = planner_stopping;
+}
+
+/**
+ * @brief decelerate all axes to a stop on the path, queued moves are discarded
+ * @note returns immediately
+ */
+void XRTLinterpolator::stop() {
+    portENTER_CRITICAL(&groupMux);
+    halt();
+    portEXIT_CRITICAL(&groupMux);
+}
+
+/**
+ * @returns true while moves are executed
+ */
+bool XRTLinterpolator::isRunning() {
+    portENTER_CRITICAL(&groupMux);
+    bool running = timerActive;
+    portEXIT_CRITICAL(&groupMux);
+    return running;
+}
+
+/**
+ * @brief get the position at which the queued moves end
+ * @param positions receives one position per axis in steps
+ * @note while idle, the current positions are returned
+ */
+void XRTLinterpolator::plannedPosition(long *positions) {
+    portENTER_CRITICAL(&groupMux);
+    for (uint8_t i = 0; i < axisCount; i++) {
+        positions[i] = (count > 0) ? planned[i] : axis[i]->currentPosition();
+    }
+    portEXIT_CRITICAL(&groupMux);
+}
+
+/**
+ * @returns number of queued moves, including the one being executed
+ */
+uint8_t XRTLinterpolator::queued() {
+    return count;
+}
+
+plannerState_t XRTLinterpolator::state() {
+    return plannerState;
+}
+
+/**
+ * @returns largest delay of a step against its schedule; µs
+ */
+uint32_t XRTLinterpolator::peakJitter() {
+    return maxJitter;
+}
+
+/**
+ * @returns average delay of the steps against their schedule; µs
+ */
+uint32_t XRTLinterpolator::meanJitter() {
+    portENTER_CRITICAL(&groupMux);
+    uint32_t mean = (jitterCount > 0) ? jitterSum / jitterCount : 0;
+    portEXIT_CRITICAL(&groupMux);
+    return mean;
+}
@@ -0,0 +1,120 @@
+#ifndef XRTLINTERPOLATOR_H
+#define XRTLINTERPOLATOR_H
+
+#include "modules/stepper/XRTLmotor.h"
+
+#define INTERPOLATOR_MAX_AXES 4     // motors that can be moved together
+#define INTERPOLATOR_QUEUE_LENGTH 16 // segments that can be planned ahead
+
+enum plannerState_t {
+    planner_idle,
+    planner_accelerating,
+    planner_cruising,
+    planner_decelerating,
+    planner_stopping // decelerating after a stop, the queue was discarded
+};
+
+static const char *plannerStateName[5] = {
+    "idle",
+    "accelerating",
+    "cruising",
+    "decelerating",
+    "stopping"
+};
+
+// straight move of all axes, planned with the speeds at its ends
+struct segment_t {
+    long target[INTERPOLATOR_MAX_AXES];
+    uint32_t delta[INTERPOLATOR_MAX_AXES]; // distance of every axis
+    bool forward[INTERPOLATOR_MAX_AXES];   // direction of every axis
+    float unit[INTERPOLATOR_MAX_AXES];     // direction of the path
+    uint32_t length;                       // distance of the major axis
+    uint32_t end;                          // steps of the major axis to perform, less than length if a stop ends within
+    float pathLength;                      // steps
+    float ratio;                           // steps of the major axis per step along the path
+
+    // speeds along the path; steps/s
+    float maxEntry; // limited by the corner to the previous segment
+    float entry;
+    float exit;
+};
+
+// linear interpolation of several stepper motors from a single esp_timer
+// the axis with the longest distance (major axis) steps on every timer call, the other axes are
+// stepped by a Bresenham-style error accumulator. All axes start and finish together and reach the
+// target on a straight line. Speed and acceleration apply to the path, not to the individual axes.
+// Moves are queued: the planner looks ahead over the queue and passes corners at the speed permitted
+// by the junction deviation instead of stopping at the end of every segment.
+class XRTLinterpolator {
+private:
+    XRTLmotor *axis[INTERPOLATOR_MAX_AXES];
+    uint8_t axisCount = 0;
+
+    esp_timer_handle_t timer = NULL;
+    esp_timer_handle_t pulseTimer = NULL; // ends the step pulses of the step/dir axes
+    portMUX_TYPE groupMux = portMUX_INITIALIZER_UNLOCKED;
+    bool timerActive = false;
+
+    float speed = 500.0f;        // along the path; steps/s
+    float acceleration = 500.0f; // along the path; steps/s²
+    float deviation = 5.0f;      // permitted distance between the path and the corner at a junction; steps
+
+    // ring buffer of planned segments, the first one is executed
+    segment_t queue[INTERPOLATOR_QUEUE_LENGTH];
+    uint8_t head = 0;
+    uint8_t count = 0;
+    long planned[INTERPOLATOR_MAX_AXES]; // target of the last queued segment
+    bool halting = false;
+    plannerState_t plannerState = planner_idle;
+
+    // current segment, in steps of the major axis
+    uint32_t error[INTERPOLATOR_MAX_AXES]; // Bresenham accumulators
+    uint32_t end = 0;                      // step at which the segment ends, less than its length after a stop
+    uint32_t done = 0;                     // steps performed
+    bool aimed = false;                    // directions of the current segment are set
+    bool direction[INTERPOLATOR_MAX_AXES]; // direction last set at every axis
+    float rate = 0.0f;                     // current speed of the major axis; steps/s
+
+    int64_t nextStep = 0; // µs
+    uint32_t lastJitter = 0;
+    uint32_t maxJitter = 0;
+    uint64_t jitterSum = 0;
+    uint32_t jitterCount = 0;
+
+    void tick();
+    void endPulses();
+    void startSegment();
+    uint32_t interval();
+    uint32_t schedule(int64_t now, uint32_t delay);
+    void recalculate();
+    void halt();
+
+    friend void interpolatorTimer(void *arg);
+    friend void interpolatorPulse(void *arg);
+
+public:
+    ~XRTLinterpolator();
+
+    bool begin();
+    bool setAxes(XRTLmotor **motors, uint8_t motorCount);
+
+    void setMaxSpeed(float pathSpeed);
+    void setAcceleration(float pathAcceleration);
+    void setDeviation(float junctionDeviation);
+
+    bool add(const long *targets);
+    void stop();
+    bool isRunning();
+
+    void plannedPosition(long *positions);
+    uint8_t queued();
+    plannerState_t state();
+
+    uint32_t peakJitter();
+    uint32_t meanJitter();
+};
+
+void interpolatorTimer(void *arg);
+void interpolatorPulse(void *arg);
+
+#endif
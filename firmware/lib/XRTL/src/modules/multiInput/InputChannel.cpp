@@ -0,0 +1,46 @@
+#include "InputChannel.h"
+
+InputChannel::InputChannel() {
+    parameters.setKey("");
+    parameters.add(pin, "pin", "int");
+    parameters.add(rangeChecking, "rangeChecking", "");
+    parameters.addDependent(loBound, "loBound", "float", "rangeChecking", true);
+    parameters.addDependent(hiBound, "hiBound", "float", "rangeChecking", true);
+}
+
+void InputChannel::saveSettings(JsonObject &settings) {
+    parameters.save(settings);
+    conversions.save(settings);
+}
+
+void InputChannel::loadSettings(JsonObject &settings, bool debugMode) {
+    parameters.load(settings);
+    if (debugMode) parameters.print();
+    conversions.load(settings, debugMode);
+}
+
+/**
+ * @brief edit the channel via the Serial interface
+ * @returns false if the user chose to return
+ */
+bool InputChannel::dialog() {
+    Serial.println("");
+    Serial.printf("channel on pin %d\n", pin);
+    Serial.println("");
+    Serial.println("b: basic settings");
+    Serial.println("m: manage conversions");
+    Serial.println("r: return");
+    Serial.println("");
+
+    String choice = serialInput("send single letter to edit settings: ");
+    if (choice == "r")
+        return false;
+    else if (choice == "b")
+        parameters.setViaSerial();
+    else if (choice == "m") {
+        while (conversions.dialog()) {
+        }
+    }
+
+    return true;
+}
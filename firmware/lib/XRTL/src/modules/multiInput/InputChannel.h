@@ -0,0 +1,36 @@
+#ifndef INPUTCHANNEL_H
+#define INPUTCHANNEL_H
+
+#include "modules/input/XRTLfilter.h"
+#include "modules/input/conversions/ConversionChain.h"
+
+// single channel of the MultiInputModule: pin, range and conversions
+class InputChannel {
+public:
+    ParameterPack parameters;
+    ConversionChain conversions;
+
+    // number of the physical input pin, must be attached to ADC1
+    uint8_t pin = 36;
+    bool rangeChecking = false;
+    double loBound = 0.0;    // converted value below which input_trigger_low is sent
+    double hiBound = 3300.0; // converted value above which input_trigger_high is sent
+
+    // filtering
+    XRTLfilter filter;
+    uint32_t sum = 0; // decimation: sum of the samples in the current slot, mV
+    uint32_t count = 0;
+    bool filterReady = false; // filter is initialized with the first value
+
+    double value = 0.0; // last converted value
+    bool lastState = false;
+    int64_t nextCheck = 0; // range checking of this channel is paused until then after a transition; µs
+
+    InputChannel();
+
+    void saveSettings(JsonObject &settings);
+    void loadSettings(JsonObject &settings, bool debugMode);
+    bool dialog();
+};
+
+#endif
@@ -0,0 +1,450 @@
+#include "MultiInputModule.h"
+
+MultiInputModule::MultiInputModule(String moduleName) {
+    id = moduleName;
+
+    parameters.setKey(id);
+    parameters.add(type, "type");
+    parameters.add(sampleRate, "sampleRate", "Hz");
+    parameters.add(averageTime, "averageTime", "ms");
+    parameters.add(rawBlocks, "rawBlocks", "y/n");
+    parameters.add(blockRate, "blockRate", "Hz");
+    parameters.add(deadMicroSeconds, "deadMicroSeconds", "µs");
+
+    for (int i = 0; i < 16; i++) {
+        channelOfAdc[i] = -1;
+    }
+}
+
+MultiInputModule::~MultiInputModule() {
+    delete sampler;
+    for (int i = 0; i < channelCount; i++) {
+        delete channel[i];
+    }
+    free(blockSamples);
+    free(blockData);
+}
+
+moduleType MultiInputModule::getType() {
+    return type;
+}
+
+void MultiInputModule::setup() {
+    if (channelCount == 0) {
+        debug("no channels configured, input deactivated");
+        return;
+    }
+
+    // every pin must be attached to a distinct ADC1 channel
+    uint8_t pins[MULTI_INPUT_CHANNELS];
+    for (int i = 0; i < channelCount; i++) {
+        pins[i] = channel[i]->pin;
+        int8_t adcChannel = digitalPinToAnalogChannel(pins[i]);
+        if (adcChannel < 0 || adcChannel >= SOC_ADC_MAX_CHANNEL_NUM || channelOfAdc[adcChannel] >= 0) {
+            debug("WARNING: pin %d is no ADC1 pin or used twice, input deactivated", pins[i]);
+            return;
+        }
+        channelOfAdc[adcChannel] = i;
+        pinMode(pins[i], INPUT);
+    }
+
+    sampler = new XRTLsampler;
+    if (!sampler->begin(pins, channelCount, sampleRate)) {
+        delete sampler;
+        sampler = NULL;
+        debug("WARNING: unable to start sampling (I2S0 in use?), input deactivated");
+
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to start sampling";
+        if (i2sOwner()) {
+            errmsg += ": I2S0 used by ";
+            errmsg += i2sOwner();
+        }
+        sendError(hardware_failure, errmsg);
+        return;
+    }
+
+    configureFilters();
+    debug("scanning %d channels at %d Hz each", channelCount, sampleRate / channelCount);
+}
+
+void MultiInputModule::loop() {
+    if (!sampler) return;
+
+    uint16_t block[64];
+    uint32_t count;
+    while ((count = sampler->read(block, 64)) > 0) {
+        uint32_t sampleIndex = sampler->index() - count; // index of block[0]
+        for (uint32_t i = 0; i < count; i++) {
+            processSample(block[i], sampleIndex + i);
+        }
+    }
+
+    for (int i = 0; i < channelCount; i++) {
+        channel[i]->value = channel[i]->filter.read();
+        channel[i]->conversions.apply(channel[i]->value);
+    }
+
+    checkRange(esp_timer_get_time());
+}
+
+void MultiInputModule::stop() {
+    if (isStreaming) stopStreaming();
+}
+
+/**
+ * @brief derive decimation and window length of the channel filters from averaging time and channel rate
+ */
+void MultiInputModule::configureFilters() {
+    if (!sampler) return;
+
+    double channelRate = sampler->sampleRate() / channelCount;
+    uint32_t windowSamples = max((uint32_t)1, (uint32_t)(channelRate * averageTime / 1000.0));
+    decimation = (windowSamples + FILTER_MAX_LENGTH - 1) / FILTER_MAX_LENGTH;
+
+    for (int i = 0; i < channelCount; i++) {
+        channel[i]->filter.configure(moving_average, windowSamples / decimation);
+        channel[i]->sum = 0;
+        channel[i]->count = 0;
+        channel[i]->filterReady = false;
+    }
+}
+
+/**
+ * @brief sort a sample into its channel and the current block
+ * @param raw sample as delivered by the sampler
+ * @param sampleIndex index of the sample
+ */
+void MultiInputModule::processSample(uint16_t raw, uint32_t sampleIndex) {
+    int8_t i = channelOfAdc[XRTLsampler::channelOf(raw)];
+    if (i < 0) return;
+
+    uint32_t milliVolts = sampler->toMilliVolts(raw);
+    InputChannel *current = channel[i];
+    current->sum += milliVolts;
+    if (++current->count >= decimation) {
+        uint16_t sample = (current->sum << FILTER_FRACTION) / current->count;
+        if (current->filterReady) {
+            current->filter.push(sample);
+        } else {
+            current->filter.reset(sample);
+            current->filterReady = true;
+        }
+        current->sum = 0;
+        current->count = 0;
+    }
+
+    if (!isStreaming) return;
+
+    if (i != framePosition) { // samples were lost, resynchronize at the start of the next frame
+        framePosition = 0;
+        if (i != 0) return;
+    }
+    if (i == 0) frameStart = sampleIndex;
+
+    blockSamples[frameCount * channelCount + i] = milliVolts << FILTER_FRACTION;
+    if (++framePosition < channelCount) return;
+
+    framePosition = 0;
+    if (frameCount == 0) blockTime = sampler->timestamp(frameStart);
+    if (++frameCount < blockFrames) return;
+
+    sendBlock();
+    frameCount = 0;
+}
+
+/**
+ * @brief compare every channel against its bounds and notify on transitions
+ * @param now current time; µs
+ * @note the dead time after a transition only pauses the channel that changed, the others are checked on
+ */
+void MultiInputModule::checkRange(int64_t now) {
+    for (int i = 0; i < channelCount; i++) {
+        InputChannel *current = channel[i];
+        if (!current->rangeChecking || !current->filterReady || now < current->nextCheck) continue;
+
+        if (current->value >= current->hiBound && !current->lastState) {
+            debug("high input on channel %d (pin %d): %f", i, current->pin, current->value);
+            current->lastState = true;
+            current->nextCheck = now + deadMicroSeconds;
+            notify(input_trigger_high);
+        } else if (current->value < current->loBound && current->lastState) {
+            debug("low input on channel %d (pin %d): %f", i, current->pin, current->value);
+            current->lastState = false;
+            current->nextCheck = now + deadMicroSeconds;
+            notify(input_trigger_low);
+        }
+    }
+}
+
+/**
+ * @brief allocate the block buffers and start streaming
+ * @returns true if streaming started
+ */
+bool MultiInputModule::startStreaming() {
+    if (!sampler) return false;
+    if (isStreaming) {
+        debug("stream already active");
+        return true;
+    }
+
+    double frameRate = sampler->sampleRate() / channelCount;
+    blockFrames = constrain((uint32_t)(frameRate / max(blockRate, (uint16_t)1)), (uint32_t)1, (uint32_t)(MULTI_INPUT_BLOCK_MAX / channelCount));
+
+    free(blockSamples);
+    free(blockData);
+    blockSamples = (uint16_t *)malloc(blockFrames * channelCount * sizeof(uint16_t));
+    blockData = (uint8_t *)malloc(blockFrames * channelCount * sizeof(float));
+    if (!blockSamples || !blockData) {
+        free(blockSamples);
+        free(blockData);
+        blockSamples = NULL;
+        blockData = NULL;
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] unable to allocate block buffer";
+        sendError(hardware_failure, errmsg);
+        return false;
+    }
+
+    frameCount = 0;
+    framePosition = 0;
+    isStreaming = true;
+    sendStatus();
+    debug("streaming blocks of %d frames", blockFrames);
+    return true;
+}
+
+/**
+ * @brief stop streaming and release the block buffers
+ */
+void MultiInputModule::stopStreaming() {
+    if (!isStreaming) {
+        debug("stream already inactive");
+        return;
+    }
+
+    isStreaming = false;
+    free(blockSamples);
+    free(blockData);
+    blockSamples = NULL;
+    blockData = NULL;
+    sendStatus();
+    debug("stopped streaming values");
+}
+
+/**
+ * @brief send the current block as binary attachment
+ * @note samples are interleaved: frame 0 of all channels, frame 1 of all channels, ...
+ * channel c of frame f was taken at time + f * period + c * period / channels (µs, esp_timer)
+ */
+void MultiInputModule::sendBlock() {
+    DynamicJsonDocument doc(512);
+    JsonArray event = doc.to<JsonArray>();
+
+    event.add("data");
+    JsonObject payload = event.createNestedObject();
+    payload["controlId"] = id;
+    payload["type"] = "block";
+    payload["format"] = rawBlocks ? "int16" : "float32";
+    payload["channels"] = channelCount;
+    payload["count"] = blockFrames;
+    payload["time"] = blockTime;
+    payload["period"] = 1000000.0 * channelCount / sampler->sampleRate();
+
+    JsonObject data = payload.createNestedObject("data");
+    data["_placeholder"] = true;
+    data["num"] = 0;
+
+    String leadFrame = "451-";
+    serializeJson(doc, leadFrame);
+
+    uint32_t sampleCount = blockFrames * channelCount;
+    size_t length;
+    if (rawBlocks) {
+        int16_t *samples = (int16_t *)blockData;
+        for (uint32_t i = 0; i < sampleCount; i++) {
+            samples[i] = (blockSamples[i] + (1 << (FILTER_FRACTION - 1))) >> FILTER_FRACTION;
+        }
+        length = sampleCount * sizeof(int16_t);
+    } else {
+        float *samples = (float *)blockData;
+        for (uint32_t i = 0; i < sampleCount; i++) {
+            double sample = ((double)blockSamples[i]) / (1 << FILTER_FRACTION);
+            channel[i % channelCount]->conversions.apply(sample);
+            samples[i] = sample;
+        }
+        length = sampleCount * sizeof(float);
+    }
+
+    sendBinary(leadFrame, blockData, length);
+}
+
+void MultiInputModule::saveSettings(JsonObject &settings) {
+    JsonObject subSettings;
+    parameters.save(settings, subSettings);
+
+    JsonArray channelSettings = subSettings.createNestedArray("channels");
+    for (int i = 0; i < channelCount; i++) {
+        JsonObject saveChannelConfig = channelSettings.createNestedObject();
+        channel[i]->saveSettings(saveChannelConfig);
+    }
+}
+
+void MultiInputModule::loadSettings(JsonObject &settings) {
+    JsonObject subSettings;
+    parameters.load(settings, subSettings);
+    if (debugging && *debugging) parameters.print();
+
+    JsonArray loadedChannels = subSettings["channels"];
+    if (loadedChannels.isNull()) return;
+
+    for (JsonVariant value : loadedChannels) { // iterate over all objects within loadedChannels
+        if (channelCount == MULTI_INPUT_CHANNELS) {
+            debug("WARNING: maximum number of channels reached");
+            break;
+        }
+        JsonObject channelSettings = value.as<JsonObject>();
+        channel[channelCount] = new InputChannel;
+        channel[channelCount++]->loadSettings(channelSettings, debugging && *debugging);
+    }
+}
+
+void MultiInputModule::setViaSerial() {
+    while (dialog()) {
+    }
+}
+
+bool MultiInputModule::dialog() {
+    highlightString(id.c_str(), '-');
+
+    Serial.println("available settings:");
+    Serial.println("");
+    Serial.println("b: basic settings");
+    Serial.println("c: manage channels");
+    Serial.println("r: return");
+    Serial.println("");
+
+    String choice = serialInput("send single letter to edit settings: ");
+    if (choice == "r")
+        return false;
+    else if (choice == "b")
+        parameters.setViaSerial();
+    else if (choice == "c") {
+        while (channelDialog()) {
+        }
+    }
+
+    return true;
+}
+
+bool MultiInputModule::channelDialog() {
+    Serial.println("");
+    Serial.println(centerString("current channels", 55, ' '));
+    Serial.println("");
+
+    for (int i = 0; i < channelCount; i++) {
+        Serial.printf("%d: pin %d, %d conversions\n", i, channel[i]->pin, channel[i]->conversions.size());
+    }
+
+    Serial.println("");
+    Serial.println("a: add channel");
+    Serial.println("d: delete channel");
+    Serial.println("r: return");
+
+    Serial.println("");
+    String choice = serialInput("send single letter or number to edit channel: ");
+    uint8_t choiceNum = choice.toInt();
+
+    if (choice == "r") {
+        return false;
+    } else if (choice == "a") {
+        if (channelCount == MULTI_INPUT_CHANNELS) {
+            Serial.println("WARNING: maximum number of channels reached");
+            return true;
+        }
+        channel[channelCount] = new InputChannel;
+        channel[channelCount++]->parameters.setViaSerial();
+    } else if (choice == "d") {
+        Serial.println("");
+        uint8_t deleteChoice = serialInput("send number to delete channel: ").toInt();
+        if (deleteChoice >= channelCount) return true;
+
+        delete channel[deleteChoice];
+        for (int i = deleteChoice; i < channelCount - 1; i++) {
+            channel[i] = channel[i + 1];
+        }
+        channel[--channelCount] = NULL;
+    } else if (choiceNum < channelCount) {
+        while (channel[choiceNum]->dialog()) {
+        }
+    }
+
+    return true;
+}
+
+bool MultiInputModule::getStatus(JsonObject &status) {
+    if (sampler == NULL) {
+        String errmsg = "[";
+        errmsg += id;
+        errmsg += "] input not initialized, check pins";
+        sendError(hardware_failure, errmsg);
+        return false;
+    }
+
+    status["averageTime"] = averageTime;
+    status["sampleRate"] = sampler->sampleRate();
+    status["channelRate"] = sampler->sampleRate() / channelCount;
+    status["stream"] = isStreaming;
+    if (isStreaming) status["blockFrames"] = blockFrames;
+
+    JsonArray values = status.createNestedArray("input");
+    for (int i = 0; i < channelCount; i++) {
+        values.add(channel[i]->value);
+    }
+
+    return true;
+}
+
+void MultiInputModule::handleCommand(String &controlId, JsonObject &command) {
+    if (!isModule(controlId) && controlId != "*") return;
+
+    bool temp = false;
+    if (getValue<bool>("getStatus", command, temp) && temp) {
+        sendStatus();
+    }
+
+    if (!sampler) return; // settings unavailable if deactivated
+
+    if (getValue<bool>("stream", command, temp)) {
+        if (temp) {
+            startStreaming();
+        } else {
+            stopStreaming();
+        }
+    }
+
+    if (getValue<uint16_t>("averageTime", command, averageTime)) {
+        configureFilters();
+        sendStatus();
+    }
+
+    bool blockChanged = getValue<bool>("rawBlocks", command, rawBlocks);
+    blockChanged |= getAndConstrainValue<uint16_t>("blockRate", command, blockRate, 1, 1000);
+    if (blockChanged && isStreaming) { // restart with the new block length
+        stopStreaming();
+        startStreaming();
+    }
+}
+
+void MultiInputModule::handleInternal(internalEvent eventId, String &sourceId) {
+    switch (eventId) {
+    case socket_disconnected: {
+        if (!isStreaming) return;
+        stopStreaming();
+        debug("stream stopped due to disconnect event");
+        return;
+    }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef MULTIINPUTMODULE_H
+#define MULTIINPUTMODULE_H
+
+#include "InputChannel.h"
+#include "modules/input/XRTLsampler.h"
+
+#define MULTI_INPUT_CHANNELS SAMPLER_MAX_CHANNELS // maximum number of channels
+#define MULTI_INPUT_BLOCK_MAX 4096                // maximum number of samples per block, all channels
+
+// several ADC1 pins scanned by a single continuous sampler
+// the channels are sampled in turn at fixed intervals, every channel has its own conversions and range
+// WARNING: uses I2S0, not available while a camera module or a continuous input module is present
+class MultiInputModule : public XRTLmodule {
+private:
+    uint8_t channelCount = 0;
+    InputChannel *channel[MULTI_INPUT_CHANNELS];
+    int8_t channelOfAdc[16]; // channel index for every ADC1 channel, -1 if not scanned
+
+    XRTLsampler *sampler = NULL;
+    uint32_t sampleRate = 40000; // total sample rate in Hz, shared by all channels
+    uint16_t averageTime = 100;  // time that the channel values are averaged for in milli seconds
+    uint32_t decimation = 1;     // samples per filter input and channel
+
+    uint32_t deadMicroSeconds = 0; // pause of the range checking of a channel after its transition
+
+    // streaming: all channels interleaved in binary blocks, one frame holds one sample of every channel
+    bool isStreaming = false;
+    bool rawBlocks = false;        // int16 raw mV instead of converted float32 values
+    uint16_t blockRate = 10;       // blocks per second, sets the number of frames per block
+    uint32_t blockFrames = 0;      // frames per block
+    uint32_t frameCount = 0;       // complete frames in the current block
+    uint8_t framePosition = 0;     // channel expected next
+    uint32_t frameStart = 0;       // sample index of the first sample of the current frame
+    int64_t blockTime = 0;         // time of the first sample of the block; µs
+    uint16_t *blockSamples = NULL; // interleaved samples, mV (Q4)
+    uint8_t *blockData = NULL;     // packed block as sent
+
+public:
+    MultiInputModule(String moduleName);
+    ~MultiInputModule();
+    moduleType type = xrtl_multiInput;
+    moduleType getType();
+
+    void setup();
+    void loop();
+    void stop();
+
+    void saveSettings(JsonObject &settings);
+    void loadSettings(JsonObject &settings);
+    void setViaSerial();
+    bool dialog();
+    bool channelDialog();
+    bool getStatus(JsonObject &status);
+
+    void configureFilters();
+    void processSample(uint16_t raw, uint32_t sampleIndex);
+    void checkRange(int64_t now);
+
+    bool startStreaming();
+    void stopStreaming();
+    void sendBlock();
+
+    void handleCommand(String &controlId, JsonObject &command);
+    void handleInternal(internalEvent eventId, String &sourceId);
+};
+
+#endif
@@ -28,6 +28,22 @@ void OutputModule::pulse(uint16_t milliSeconds) {
     out->toggle(true);
 }
 
+/**
+ * @brief set the output level from another module
+ * @param powerLvl pwm power level, relays switch on at 128 and above
+ * @note no status is sent, meant for frequent updates from controllers
+ */
+void OutputModule::write(uint8_t powerLvl) {
+    if (!out) return;
+
+    if (pwm) {
+        out->write(powerLvl);
+        if (!out->getState()) out->toggle(true);
+    } else {
+        out->toggle(powerLvl >= 128);
+    }
+}
+
 void OutputModule::saveSettings(JsonObject &settings) {
     parameters.save(settings);
 }
@@ -51,6 +67,7 @@ bool OutputModule::getStatus(JsonObject &status) {
     if (!pwm) return true;
     
     status["pwm"] = out->read();
+    status["frequency"] = frequency;
     return true;
 }
 
@@ -138,6 +155,19 @@ void OutputModule::handleCommand(String &controlId, JsonObject &command) {
             out->write(powerLvl);
             sendStatus();
         }
+
+        uint16_t targetFrequency;
+        if (getAndConstrainValue<uint16_t>("frequency", command, targetFrequency, 1, 40000)) {
+            if (out->setFrequency(targetFrequency)) {
+                frequency = targetFrequency;
+            } else {
+                String errmsg = "[";
+                errmsg += id;
+                errmsg += "] unable to set frequency";
+                sendError(hardware_failure, errmsg);
+            }
+            sendStatus();
+        }
     }
 
     bool targetState;
@@ -32,6 +32,7 @@ public:
     moduleType getType();
 
     void pulse(uint16_t milliSeconds);
+    void write(uint8_t powerLvl);
 
     void setup();
     void loop();
@@ -71,6 +71,24 @@ void XRTLoutput::write(uint8_t powerLvl) {
     toggle(state); // update powerlevel
 }
 
+/**
+ * @brief change the frequency of the pwm signal
+ * @param pwmFrequency new frequency in Hz
+ * @returns true if the frequency could be set
+ * @note the timer starts over, the pwm period begins when this returns
+ */
+bool XRTLoutput::setFrequency(uint16_t pwmFrequency) {
+    if (!pwm) return false;
+    if (ledcSetup(channel, pwmFrequency, 8) == 0) {
+        ledcSetup(channel, frequency, 8); // restore the previous frequency
+        toggle(state);
+        return false;
+    }
+    frequency = pwmFrequency;
+    toggle(state);
+    return true;
+}
+
 /**
  * @brief get the current pwm powerlevel
  * @returns powerlevel as 8-bit integer
@@ -21,6 +21,7 @@ public:
 
     void toggle(bool targetState);
     void write(uint8_t powerLvl);
+    bool setFrequency(uint16_t pwmFrequency);
     
     uint8_t read();
     bool getState();
@@ -19,6 +19,7 @@ ServoModule::ServoModule(String moduleName) {
     parameters.add(initial, "initial", "float");
 
     parameters.add(pin, "pin", "int");
+    parameters.add(streamRate, "streamRate", "Hz");
 
     parameters.add(infoLED, "infoLED", "String");
 }
@@ -47,6 +48,8 @@ bool ServoModule::getStatus(JsonObject &status) {
     status["busy"] = wasRunning;
     status["absolute"] = read();
     status["relative"] = mapFloat(currentTicks, minTicks, maxTicks, 0, 100);
+    status["stream"] = positions.enabled();
+    status["streamRate"] = positions.rate();
 
     return true;
 }
@@ -59,6 +62,8 @@ void ServoModule::setup() {
         stepSize = round((double) maxSpeed * ((double) maxDuty - (double) minDuty) / ((double) maxAngle - (double) minAngle) * (double) 0.065535);
     }
 
+    positions.setRate(streamRate);
+
     ledcSetup(channel, frequency, 16); // 16 bit resolution, maximum duty is 65535
     ledcAttachPin(pin, channel);
 
@@ -77,9 +82,12 @@ void ServoModule::setup() {
 void ServoModule::loop() {
     if (!wasRunning) return;
 
+    positions.stream(this, read(), targetValue(), false);
+
     if (esp_timer_get_time() < nextStep) return;
 
     if (currentTicks == targetTicks) {
+        positions.stream(this, read(), targetValue(), true);
         if (!holdOn) ledcWrite(channel, 0); // if hold is deactivated: power down motor
 
         if (infoLED != "") {
@@ -117,6 +125,7 @@ void ServoModule::stop() {
     if (!wasRunning) return;
     wasRunning = false;
     targetTicks = currentTicks;
+    positions.stream(this, read(), targetValue(), true);
     ledcWrite(channel, 0);
     notify(ready);
 }
@@ -144,6 +153,16 @@ void ServoModule::handleCommand(String &controlId, JsonObject &command) {
         while (wasRunning) loop();
     }
 
+    if (getValue<bool>("stream", command, tempBool)) {
+        positions.enable(tempBool);
+        sendStatus();
+    }
+
+    if (getAndConstrainValue<uint16_t>("streamRate", command, streamRate, 1, POSITION_STREAM_MAX_RATE)) {
+        positions.setRate(streamRate);
+        sendStatus();
+    }
+
     if (getValue<bool>("hold", command, holdOn)) {
         debug("hold %sactive", holdOn ? "" : "in");
     }
@@ -173,6 +192,10 @@ float ServoModule::read() {
     return mapFloat(currentTicks, minTicks, maxTicks, minAngle, maxAngle);
 }
 
+float ServoModule::targetValue() {
+    return mapFloat(targetTicks, minTicks, maxTicks, minAngle, maxAngle);
+}
+
 /**
  * @brief immediately sets the servo to the new target
  * @param target value that the servo motor should move to (value range)
@@ -1,6 +1,7 @@
 #ifndef SERVOMODULE_H
 #define SERVOMODULE_H
 
+#include "common/XRTLpositionStream.h"
 #include "modules/XRTLmodule.h"
 
 class ServoModule : public XRTLmodule {
@@ -32,6 +33,9 @@ private:
 
     uint8_t pin = 25;
 
+    XRTLpositionStream positions;
+    uint16_t streamRate = 50; // position samples per second while moving
+
     String infoLED = "";
 
 public:
@@ -40,6 +44,7 @@ public:
     moduleType getType();
 
     float read();                         // read the current servo position, delivered on value range
+    float targetValue();                  // target of the current motion, delivered on value range
     void write(float target);             // move servo to target value on value range
     void driveServo(JsonObject &command); // process the command object and move servo if needed
 
@@ -5,6 +5,7 @@ StepperModule::StepperModule(String moduleName) {
 
     parameters.setKey(id);
     parameters.add(type, "type");
+    parameters.add(driver, "driver", "0: 4 coil pins, 1: step/dir/enable");
 
     parameters.add(pin[0], "pin1", "int");
     parameters.add(pin[1], "pin2", "int");
@@ -20,9 +21,23 @@ StepperModule::StepperModule(String moduleName) {
 
     parameters.add(initial, "initial", "int");
 
+    parameters.add(switchPin[0], "lowerSwitch", "pin, 255: none");
+    parameters.add(switchPin[1], "upperSwitch", "pin, 255: none");
+    parameters.add(switchHigh, "switchHigh", "bool");
+    parameters.add(homeSpeed, "homeSpeed", "steps/s");
+    parameters.add(backOff, "backOff", "steps");
+
+    parameters.add(streamRate, "streamRate", "Hz");
+
     parameters.add(infoLED, "infoLED", "String");
 }
 
+StepperModule::~StepperModule() {
+    limitSwitch[0].end(); // the interrupts access the motor
+    limitSwitch[1].end();
+    delete stepper;
+}
+
 moduleType StepperModule::getType() {
     return xrtl_stepper;
 }
@@ -53,39 +68,182 @@ void StepperModule::setViaSerial() {
 }
 
 void StepperModule::setup() {
-    stepper = new AccelStepper(AccelStepper::HALF4WIRE, pin[0], pin[1], pin[2], pin[3]);
+    if (driver == step_dir_driver) {
+        XRTLstepDirMotor *motor = new XRTLstepDirMotor;
+        if (!motor->begin(pin[0], pin[1], pin[2])) {
+            debug("WARNING: unable to set up pulse generation");
+        }
+        stepper = motor;
+    } else {
+        XRTLcoilMotor *motor = new XRTLcoilMotor;
+        if (!motor->begin(pin[0], pin[1], pin[2], pin[3])) {
+            debug("WARNING: unable to create step timer");
+        }
+        stepper = motor;
+    }
 
     stepper->setCurrentPosition(position);
     stepper->setMaxSpeed(speed);
     stepper->setAcceleration(accel);
+    positions.setRate(streamRate);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (switchPin[i] != 255) limitSwitch[i].begin(switchPin[i], switchHigh, i == 1, stepper);
+    }
 
     if (initial != 0) {
-        stepper->move(initial);
-        wasRunning = true;
         isInitialized = false;
-        notify(busy);
+        bool upper = (initial > 0);
+        if (limitSwitch[upper].connected()) { // reference at the switch instead of a move into the mechanical stop
+            startHoming(upper);
+        } else {
+            stepper->move(initial);
+            startOperation(stepper_homing);
+        }
     }
 }
 
 void StepperModule::loop() {
-    if (stepper->isRunning()) {
-        stepper->run();
+    if (state == stepper_idle) return;
+    if (state != stepper_grouped) positions.stream(this, stepper->currentPosition(), stepper->targetPosition(), false); // a group owns the trajectory of its axes
+    if (stepper->isRunning()) return; // steps are generated by the timer
+    if (continueHoming()) return;
+
+    finishOperation();
+}
+
+/**
+ * @brief mark the stepper busy until the current motion is complete
+ * @param operation kind of motion, the target must be set already
+ * @note completion is detected by loop()
+ */
+void StepperModule::startOperation(stepperState_t operation) {
+    stepper->enableOutputs();
+    stepper->resetJitter();
+
+    bool wasIdle = (state == stepper_idle);
+    state = operation;
+    moveTarget = stepper->targetPosition();
+    debug("%s: moving from %d to %d", stepperStateName[state], stepper->currentPosition(), stepper->targetPosition());
+    sendStatus();
+    if (wasIdle) notify(busy);
+}
+
+/**
+ * @brief hand the motor over to a motion group
+ * @returns false if the stepper is busy
+ * @note the operation completes once the group releases the motor
+ */
+bool StepperModule::joinGroup() {
+    if (state != stepper_idle) return false;
+    if (!stepper->claim()) return false;
+
+    startOperation(stepper_grouped);
+    return true;
+}
+
+XRTLmotor *StepperModule::motor() {
+    return stepper;
+}
+
+int32_t StepperModule::lowerLimit() {
+    return minimum;
+}
+
+int32_t StepperModule::upperLimit() {
+    return maximum;
+}
+
+/**
+ * @brief reference the position at a limit switch: fast approach, back off, slow approach
+ * @param upper true: home at the upper switch, false: at the lower switch
+ * @note the switch is located backOff steps beyond the maximum or minimum, the sequence ends there
+ * @note the sequence is progressed by loop(), the switch interrupt ends each approach
+ */
+void StepperModule::startHoming(bool upper) {
+    homingUpper = upper;
+    isInitialized = false;
+
+    int32_t range = maximum - minimum + 2 * backOff; // the stored position is not trusted: the switch might be anywhere
+    stepper->move(upper ? range : -range);           // ignored if the switch is reached already
+    startOperation(stepper_seeking);
+}
+
+/**
+ * @brief start the next phase of the homing sequence once the previous one completed
+ * @returns true while the sequence continues
+ */
+bool StepperModule::continueHoming() {
+    if (state != stepper_seeking && state != stepper_backing && state != stepper_probing) return false;
+
+    bool reached = limitSwitch[homingUpper].reached();
+    int32_t direction = homingUpper ? 1 : -1;
+
+    if (state == stepper_seeking && reached) {
+        stepper->move(-direction * backOff);
+        state = stepper_backing;
+        debug("switch found at %d, backing off", stepper->currentPosition());
+        return true;
     }
-    else if (wasRunning) {
-        if (!holdOn) stepper->disableOutputs();
 
-        if (infoLED != "") {
-            XRTLdisposableCommand command(infoLED);
-            command.add("hold", false);
-            sendCommand(command);
-        }
+    if (state == stepper_backing && !reached) {
+        stepper->setMaxSpeed(homeSpeed);
+        stepper->move(direction * 2 * backOff);
+        state = stepper_probing;
+        return true;
+    }
 
-        wasRunning = false;
+    if (state == stepper_probing && reached) { // leave the switch, the range ends at the back off distance from it
+        int32_t end = homingUpper ? maximum : minimum;
+        stepper->setCurrentPosition(end + direction * backOff);
+        isInitialized = true;
+        debug("homed, switch at %d", stepper->currentPosition());
+
+        stepper->setMaxSpeed(speed);
+        stepper->moveTo(end);
+        moveTarget = end;
+        state = stepper_moving;
+        return true;
+    }
 
-        debug("done moving");
-        sendStatus();
-        notify(ready);
+    String error = "[";
+    error += id;
+    error += "] homing failed: ";
+    error += reached ? "switch still active after backing off" : "switch not reached";
+    sendError(hardware_failure, error);
+    return false;
+}
+
+/**
+ * @brief power down and report after the motion completed
+ */
+void StepperModule::finishOperation() {
+    if (state != stepper_grouped) positions.stream(this, stepper->currentPosition(), stepper->targetPosition(), true);
+    if (state == stepper_homing) isInitialized = true;
+    stepper->setMaxSpeed(speed); // homing approaches the switch slowly
+
+    int32_t current = stepper->currentPosition();
+    if ((state == stepper_moving || state == stepper_resetting) && current != moveTarget && stepper->atLimit(moveTarget > current)) {
+        String error = "[";
+        error += id;
+        error += "] stopped by limit switch at ";
+        error += current;
+        sendError(out_of_bounds, error);
     }
+
+    debug("%s: done", stepperStateName[state]);
+    state = stepper_idle;
+
+    if (!holdOn) stepper->disableOutputs();
+
+    if (infoLED != "") {
+        XRTLdisposableCommand command(infoLED);
+        command.add("hold", false);
+        sendCommand(command);
+    }
+
+    sendStatus();
+    notify(ready);
 }
 
 bool StepperModule::getStatus(JsonObject &status) {
@@ -94,20 +252,31 @@ bool StepperModule::getStatus(JsonObject &status) {
 
     position = stepper->currentPosition(); // update position
 
-    status["busy"] = stepper->isRunning();
+    status["busy"] = (state != stepper_idle);
+    status["state"] = stepperStateName[state];
     status["absolute"] = position;
     status["relative"] = mapFloat(position, minimum, maximum, 0, 100);
+    status["stepJitter"] = stepper->meanJitter();
+    status["maxStepJitter"] = stepper->peakJitter();
+    status["lostSteps"] = stepper->lostSteps();
+    status["initialized"] = isInitialized;
+    if (limitSwitch[0].connected()) status["lowerSwitch"] = limitSwitch[0].reached();
+    if (limitSwitch[1].connected()) status["upperSwitch"] = limitSwitch[1].reached();
+    status["stream"] = positions.enabled();
+    status["streamRate"] = positions.rate();
     return true;
 }
 
+/**
+ * @brief decelerate to a stop
+ * @note returns immediately, the timer keeps stepping until the motor stands still
+ */
 void StepperModule::stop() {
+    if (state == stepper_idle) return;
+
     stepper->stop();
-    while (stepper->isRunning()) // allow deceleration
-    {
-        stepper->run();
-        yield();
-    }
-    stepper->disableOutputs();
+    state = stepper_stopping;
+    debug("stopping at %d", stepper->targetPosition());
 }
 
 void StepperModule::handleCommand(String &controlId, JsonObject &command) {
@@ -121,24 +290,24 @@ void StepperModule::handleCommand(String &controlId, JsonObject &command) {
 
     if (getValue<bool>("stop", command, tempBool) && tempBool) {
         stop();
-    }
-
-    if (getValue<bool>("reset", command, tempBool) && tempBool) {
-        debug("reset: moving from %d to 0", stepper->currentPosition());
-        stepper->moveTo(0);
-        stepper->enableOutputs();
-        while (stepper->isRunning()) {
-            stepper->run();
-        }
-        stepper->disableOutputs();
-        debug("reset: done");
+        sendStatus();
     }
 
     if (getValue<bool>("manualSave", command, tempBool) && tempBool) {
         manualSave();
     }
 
-    if (stepper->isRunning()) {
+    if (getValue<bool>("stream", command, tempBool)) {
+        positions.enable(tempBool);
+        sendStatus();
+    }
+
+    if (getAndConstrainValue<uint16_t>("streamRate", command, streamRate, 1, POSITION_STREAM_MAX_RATE)) {
+        positions.setRate(streamRate);
+        sendStatus();
+    }
+
+    if (state != stepper_idle) {
         String error = "[";
         error += id;
         error += "] command rejected: stepper already moving";
@@ -146,6 +315,25 @@ void StepperModule::handleCommand(String &controlId, JsonObject &command) {
         return;
     }
 
+    if (getValue<bool>("reset", command, tempBool) && tempBool) {
+        stepper->moveTo(0);
+        startOperation(stepper_resetting);
+        return;
+    }
+
+    if (getValue<bool>("home", command, tempBool) && tempBool) {
+        if (!limitSwitch[0].connected() && !limitSwitch[1].connected()) {
+            String error = "[";
+            error += id;
+            error += "] unable to home: no limit switch configured";
+            sendError(hardware_failure, error);
+            return;
+        }
+
+        startHoming(!limitSwitch[0].connected()); // prefer the lower switch
+        return;
+    }
+
     driveStepper(command);
 
     uint32_t duration;
@@ -164,22 +352,23 @@ void StepperModule::handleCommand(String &controlId, JsonObject &command) {
 }
 
 void StepperModule::driveStepper(JsonObject &command) {
+    // collect the target first: the motor only accepts a new target at rest
+    int32_t target = stepper->currentPosition();
+    bool targetSet = false;
+
     int32_t moveValue = 0;
     if (getAndConstrainValue<int32_t>("move", command, moveValue, minimum - maximum, maximum - minimum)) { // full range: maximum - minimum; negative range: minimum - maximum
-        stepper->move(moveValue);
-        wasRunning = true; // check state in next loop (will issue status when movement done)
+        target += moveValue;
+        targetSet = true;
     }
 
     if (getAndConstrainValue<int32_t>("moveTo", command, moveValue, minimum, maximum)) {
-        stepper->moveTo(moveValue);
-        wasRunning = true; // check state in next loop (will issue status when movement done)
+        target = moveValue;
+        targetSet = true;
     }
 
-    int32_t target = stepper->targetPosition();
-
-    if ((target > maximum) or (target < minimum)) {
+    if (targetSet && ((target > maximum) or (target < minimum))) {
         target = constrain(target, minimum, maximum);
-        stepper->moveTo(target);
 
         String error = "[";
         error += id;
@@ -194,45 +383,41 @@ void StepperModule::driveStepper(JsonObject &command) {
 
     bool binaryCtrl;
     if (getValue<bool>("binaryCtrl", command, binaryCtrl)) {
-        if (binaryCtrl) {
-            stepper->moveTo(maximum);
-        } else {
-            stepper->moveTo(minimum);
-        }
+        target = binaryCtrl ? maximum : minimum;
+        targetSet = true;
+    }
 
-        wasRunning = true; // check state in next loop (will issue status when movement done)
+    int32_t current = stepper->currentPosition();
+    if (targetSet && target != current && stepper->atLimit(target > current)) { // the motor refuses moves towards an active switch
+        String error = "[";
+        error += id;
+        error += "] move rejected: ";
+        error += (target > current) ? "upper" : "lower";
+        error += " limit switch reached";
+        sendError(out_of_bounds, error);
+        targetSet = false;
     }
 
+    if (targetSet) stepper->moveTo(target);
+
     if (getValue<bool>("hold", command, holdOn)) {
         debug("hold %sactive", holdOn ? "" : "in");
 
         if (holdOn) {
             stepper->enableOutputs(); // ensure the motor coils are powered if hold gets called
+        } else if (state == stepper_idle) {
+            stepper->disableOutputs(); // a running movement releases the coils once it is done
         }
-
-        wasRunning = true; // check state in next loop (will issue status)
+        sendStatus();
     }
 
-    if (!stepper->isRunning()) // check whether position is reached already
+    if (stepper->distanceToGo() == 0) // check whether position is reached already
     {
         return;
     }
 
-    // estimate travelTime in ms
-    uint32_t distance = abs(stepper->targetPosition() - stepper->currentPosition());
-    uint32_t travelTime = 0;
-    if (distance > speed * speed / accel) {
-        // distance after which the motor reaches max speed (including decelleration)
-        // t = s/v_max + v_max/a
-        travelTime = 1000 * distance / speed;
-        travelTime += 1000 * speed / accel;
-    } else {
-        // time spend accellerating/decellerating
-        // t = 2 * sqrt(s/a)
-        travelTime = round(2000 * sqrt(distance / accel));
-    }
-
     if (infoLED != "") { // instruct LED to show pattern
+        uint32_t travelTime = stepper->travelTime(); // taken from the ramp that times the steps
         XRTLdisposableCommand ledCommand(infoLED);
 
         String color;
@@ -249,9 +434,5 @@ void StepperModule::driveStepper(JsonObject &command) {
         sendCommand(ledCommand);
     }
 
-    stepper->enableOutputs();
-    debug("moving from %d to %d", stepper->currentPosition(), stepper->targetPosition());
-    sendStatus();
-    notify(busy);
-    return;
+    startOperation(stepper_moving);
 }
\ No newline at end of file
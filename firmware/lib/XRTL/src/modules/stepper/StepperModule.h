@@ -1,9 +1,43 @@
 #ifndef STEPPERMODULE_H
 #define STEPPERMOUDLE_H
 
-#include "AccelStepper.h"
+#include "XRTLcoilMotor.h"
+#include "XRTLlimitSwitch.h"
+#include "XRTLstepDirMotor.h"
+#include "common/XRTLpositionStream.h"
 #include "modules/XRTLmodule.h"
 
+// hardware driving the motor
+enum stepperDriver_t {
+    coil_driver,    // four coil pins driven by GPIOs, e.g. 28BYJ-48 with ULN2003
+    step_dir_driver // external driver with step, direction and enable pin (pin1-3)
+};
+
+// operation of the stepper, progressed by loop() while the timer generates the steps
+enum stepperState_t {
+    stepper_idle,
+    stepper_moving,    // regular move
+    stepper_stopping,  // decelerating after a stop
+    stepper_resetting, // returning to position 0
+    stepper_homing,    // initial move after start up
+    stepper_grouped,   // steps are generated by a motion group
+    stepper_seeking,   // homing at a limit switch: fast approach
+    stepper_backing,   // homing at a limit switch: leaving the switch
+    stepper_probing    // homing at a limit switch: slow approach, sets the position
+};
+
+static const char *stepperStateName[9] = {
+    "idle",
+    "moving",
+    "stopping",
+    "resetting",
+    "homing",
+    "grouped",
+    "seeking",
+    "backing",
+    "probing"
+};
+
 class StepperModule : public XRTLmodule {
 private:
     uint16_t accel = 500;
@@ -13,21 +47,42 @@ private:
     int32_t maximum = 10000;
     int32_t initial = 0;
 
+    uint8_t driver = coil_driver;
     uint8_t pin[4] = {19, 22, 21, 23};
 
-    bool wasRunning = false;
+    uint8_t switchPin[2] = {255, 255}; // limit switches at the lower and upper end, 255: none
+    bool switchHigh = false;           // switches read high when reached (normally closed contact)
+    uint16_t homeSpeed = 100;          // slow approach of the switch while homing; steps/s
+    uint16_t backOff = 200;            // distance to leave the switch after the fast approach, also between switch and range; steps
+
+    stepperState_t state = stepper_idle;
+    int32_t moveTarget = 0; // target at the start of the operation
+    bool homingUpper = false;
     bool isInitialized = true;
     bool holdOn = false;
 
-    AccelStepper *stepper = NULL;
+    XRTLmotor *stepper = NULL; // steps are generated by a timer or the RMT, not by loop()
+    XRTLlimitSwitch limitSwitch[2]; // lower, upper
+    XRTLpositionStream positions;
+    uint16_t streamRate = 50; // position samples per second while moving
     String infoLED = "";
 
 public:
     StepperModule(String moduleName);
+    ~StepperModule();
     moduleType type = xrtl_stepper;
     moduleType getType();
 
     void driveStepper(JsonObject &command);
+    void startOperation(stepperState_t operation);
+    void finishOperation();
+    void startHoming(bool upper);
+    bool continueHoming();
+
+    bool joinGroup();
+    XRTLmotor *motor();
+    int32_t lowerLimit();
+    int32_t upperLimit();
 
     void saveSettings(JsonObject &settings);
     void loadSettings(JsonObject &settings);
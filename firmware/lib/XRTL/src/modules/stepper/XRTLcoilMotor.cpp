@@ -0,0 +1,332 @@
+#include "XRTLcoilMotor.h"
+
+XRTLcoilMotor::~XRTLcoilMotor() {
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+    }
+    delete stepper;
+}
+
+/**
+ * @brief attach the motor and create the step timer
+ * @param pin1 first coil pin
+ * @param pin2 second coil pin
+ * @param pin3 third coil pin
+ * @param pin4 fourth coil pin
+ * @returns true if the timer could be created
+ * @note the motor is driven in half steps (AccelStepper::HALF4WIRE)
+ */
+bool XRTLcoilMotor::begin(uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4) {
+    stepper = new XRTLaccelStepper(AccelStepper::HALF4WIRE, pin1, pin2, pin3, pin4);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = coilTimer;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "stepper";
+    return (esp_timer_create(&timerArgs, &timer) == ESP_OK);
+}
+
+/**
+ * @brief step once and keep the position in sync
+ * @param forward true: step towards higher positions
+ * @note the target follows the position, AccelStepper itself does not move the motor while grouped
+ */
+void XRTLaccelStepper::singleStep(bool forward) {
+    long position = currentPosition() + (forward ? 1 : -1);
+    setCurrentPosition(position);
+    step(position);
+}
+
+/**
+ * @brief timer callback, forwards to the motor
+ * @param arg pointer to the XRTLcoilMotor
+ */
+void coilTimer(void *arg) {
+    ((XRTLcoilMotor *)arg)->tick();
+}
+
+/**
+ * @brief perform the step that is due and schedule the next one
+ * @note runs in the esp_timer task. The steps follow absolute deadlines, the jitter is measured against them.
+ */
+void XRTLcoilMotor::tick() {
+    portENTER_CRITICAL(&motorMux);
+    if (!timerActive || ramp.finished()) { // a stop at rest ends the move without a step
+        timerActive = false;
+        nextStep = 0;
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+
+    if (limit[direction]) { // switch reached since the last step: end the move without braking
+        timerActive = false;
+        nextStep = 0;
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (nextStep != 0 && now >= nextStep) {
+        lastJitter = now - nextStep;
+        maxJitter = max(maxJitter, lastJitter);
+        jitterSum += lastJitter;
+        jitterCount++;
+    }
+
+    uint32_t delay = ramp.next();
+    stepper->singleStep(direction);
+
+    if (delay == 0) { // last step of the move
+        timerActive = false;
+        nextStep = 0;
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+
+    // schedule from the deadline, not from the late call: latencies must not add up along the move
+    // if even the next deadline is already missed, e.g. after a blocked timer task, the schedule restarts instead of bursting
+    nextStep = (nextStep != 0 && nextStep + delay > now) ? nextStep + delay : now + delay;
+    int64_t wait = nextStep - esp_timer_get_time();
+    portEXIT_CRITICAL(&motorMux);
+
+    esp_timer_start_once(timer, max(wait, (int64_t)MOTOR_MIN_DELAY));
+}
+
+/**
+ * @param speed maximum speed; steps/s
+ * @note applies to the next move
+ */
+void XRTLcoilMotor::setMaxSpeed(float speed) {
+    maxSpeed = max(lroundf(speed), 1L);
+}
+
+/**
+ * @param accel acceleration; steps/s²
+ * @note applies to the next move
+ */
+void XRTLcoilMotor::setAcceleration(float accel) {
+    acceleration = max(lroundf(accel), 1L);
+}
+
+/**
+ * @brief redefine the current position
+ * @param position new position in steps
+ * @note ignored while moving
+ */
+void XRTLcoilMotor::setCurrentPosition(long position) {
+    portENTER_CRITICAL(&motorMux);
+    if (!timerActive && !grouped) stepper->setCurrentPosition(position);
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @brief move relative to the current position
+ * @param relative distance in steps
+ */
+void XRTLcoilMotor::move(long relative) {
+    moveTo(currentPosition() + relative);
+}
+
+/**
+ * @brief move to an absolute position
+ * @param absolute target position in steps
+ * @note ignored while moving: a running move can only be stopped
+ * @note ignored if the limit switch in the direction of the move is reached
+ */
+void XRTLcoilMotor::moveTo(long absolute) {
+    if (!timer || isRunning()) return;
+
+    ramp.configure(maxSpeed, acceleration, 1000000); // rebuilds the table only after a change
+
+    portENTER_CRITICAL(&motorMux);
+    moveStart = stepper->currentPosition();
+    long distance = absolute - moveStart;
+    if (distance == 0) {
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+    direction = (distance > 0);
+    if (limit[direction]) {
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+    ramp.start(labs(distance));
+    nextStep = 0;
+    timerActive = true;
+    portEXIT_CRITICAL(&motorMux);
+
+    esp_timer_start_once(timer, MOTOR_MIN_DELAY);
+}
+
+/**
+ * @brief decelerate to a stop as fast as the acceleration permits
+ * @note returns immediately, the motor is stopped once isRunning() returns false
+ * @note while grouped, the request is passed on to the motion group
+ */
+void XRTLcoilMotor::stop() {
+    portENTER_CRITICAL(&motorMux);
+    if (grouped) {
+        haltRequest = true;
+    } else {
+        ramp.stop();
+    }
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @brief hand the step generation over to a motion group
+ * @returns false if the motor is moving or already part of a group
+ * @note the motor counts as running until release() is called
+ */
+bool XRTLcoilMotor::claim() {
+    portENTER_CRITICAL(&motorMux);
+    bool available = !grouped && !timerActive;
+    if (available) {
+        grouped = true;
+        haltRequest = false;
+    }
+    portEXIT_CRITICAL(&motorMux);
+    return available;
+}
+
+/**
+ * @brief return the step generation to the own timer
+ */
+void XRTLcoilMotor::release() {
+    portENTER_CRITICAL(&motorMux);
+    grouped = false;
+    haltRequest = false;
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @brief perform a single step immediately
+ * @param forward true: step towards higher positions
+ * @note only valid while claimed by a motion group
+ * @note a step towards a reached limit switch is dropped and requests the group to stop
+ */
+void XRTLcoilMotor::step(bool forward) {
+    portENTER_CRITICAL(&motorMux);
+    if (grouped && limit[forward]) {
+        haltRequest = true;
+    } else if (grouped) {
+        stepper->singleStep(forward);
+    }
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @returns true once if stop() was called while grouped
+ */
+bool XRTLcoilMotor::stopRequested() {
+    portENTER_CRITICAL(&motorMux);
+    bool requested = haltRequest;
+    haltRequest = false;
+    portEXIT_CRITICAL(&motorMux);
+    return requested;
+}
+
+/**
+ * @brief report the state of a limit switch
+ * @param forward true: switch at the upper end
+ * @param reached true: the switch is active
+ * @note called from the interrupt of the switch: the step timer checks the limit before every step
+ */
+void XRTLcoilMotor::setLimit(bool forward, bool reached) {
+    limit[forward] = reached;
+}
+
+/**
+ * @param forward true: switch at the upper end
+ * @returns true if the limit switch is reached
+ */
+bool XRTLcoilMotor::atLimit(bool forward) {
+    return limit[forward];
+}
+
+long XRTLcoilMotor::currentPosition() {
+    portENTER_CRITICAL(&motorMux);
+    long position = stepper->currentPosition();
+    portEXIT_CRITICAL(&motorMux);
+    return position;
+}
+
+/**
+ * @returns end of the running move, the current position at rest
+ */
+long XRTLcoilMotor::targetPosition() {
+    portENTER_CRITICAL(&motorMux);
+    long position = stepper->currentPosition();
+    if (timerActive) position = moveStart + (direction ? 1 : -1) * (long)ramp.planned();
+    portEXIT_CRITICAL(&motorMux);
+    return position;
+}
+
+long XRTLcoilMotor::distanceToGo() {
+    return targetPosition() - currentPosition();
+}
+
+/**
+ * @returns true while a move is running or a motion group controls the motor
+ */
+bool XRTLcoilMotor::isRunning() {
+    portENTER_CRITICAL(&motorMux);
+    bool running = timerActive || grouped;
+    portEXIT_CRITICAL(&motorMux);
+    return running;
+}
+
+/**
+ * @returns duration of the running move in ms, 0 at rest
+ */
+uint32_t XRTLcoilMotor::travelTime() {
+    if (!timerActive) return 0;
+    return ramp.duration(ramp.planned()) / 1000;
+}
+
+void XRTLcoilMotor::enableOutputs() {
+    portENTER_CRITICAL(&motorMux);
+    stepper->enableOutputs();
+    portEXIT_CRITICAL(&motorMux);
+}
+
+void XRTLcoilMotor::disableOutputs() {
+    portENTER_CRITICAL(&motorMux);
+    stepper->disableOutputs();
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @returns delay of the last step against its schedule; µs
+ */
+uint32_t XRTLcoilMotor::jitter() {
+    return lastJitter;
+}
+
+/**
+ * @returns largest delay of a step against its schedule since the last reset; µs
+ */
+uint32_t XRTLcoilMotor::peakJitter() {
+    return maxJitter;
+}
+
+/**
+ * @returns average delay of the steps against their schedule since the last reset; µs
+ */
+uint32_t XRTLcoilMotor::meanJitter() {
+    portENTER_CRITICAL(&motorMux);
+    uint32_t mean = (jitterCount > 0) ? jitterSum / jitterCount : 0;
+    portEXIT_CRITICAL(&motorMux);
+    return mean;
+}
+
+void XRTLcoilMotor::resetJitter() {
+    portENTER_CRITICAL(&motorMux);
+    lastJitter = 0;
+    maxJitter = 0;
+    jitterSum = 0;
+    jitterCount = 0;
+    portEXIT_CRITICAL(&motorMux);
+}
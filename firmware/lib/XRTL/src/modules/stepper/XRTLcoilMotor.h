@@ -0,0 +1,86 @@
+#ifndef XRTLCOILMOTOR_H
+#define XRTLCOILMOTOR_H
+
+#include "AccelStepper.h"
+#include "XRTLmotor.h"
+#include "XRTLramp.h"
+
+// AccelStepper with access to single steps, only used for the coil patterns: the steps are timed by XRTLramp or a motion group
+class XRTLaccelStepper : public AccelStepper {
+public:
+    using AccelStepper::AccelStepper;
+    void singleStep(bool forward);
+};
+
+// stepper motor with four coil pins, driven by a one-shot esp_timer instead of the main loop
+// the timer fires at the time of the next step, steps the motor and schedules itself for the following step.
+// The intervals are taken from the precomputed table of the ramp.
+// The timer task runs at high priority on core 0, step timing does not depend on the load of the main loop.
+// All access to the motor is guarded by a spinlock, the methods are safe to call from the main loop.
+class XRTLcoilMotor : public XRTLmotor {
+private:
+    XRTLaccelStepper *stepper = NULL;
+    esp_timer_handle_t timer = NULL;
+    portMUX_TYPE motorMux = portMUX_INITIALIZER_UNLOCKED;
+    bool timerActive = false; // a move is running
+    bool grouped = false;     // steps are generated by a motion group instead of the own timer
+    bool haltRequest = false; // stop requested while grouped, handled by the motion group
+    volatile bool limit[2] = {false, false}; // limit switch reached: lower, upper
+
+    XRTLramp ramp;               // intervals in µs
+    uint32_t maxSpeed = 500;     // steps/s
+    uint32_t acceleration = 500; // steps/s²
+    bool direction = true;       // direction of the running move
+    long moveStart = 0;          // position at the start of the move
+
+    int64_t nextStep = 0; // scheduled time of the next step, 0: unknown; µs
+
+    // step timing: delay of the steps against their schedule
+    uint32_t lastJitter = 0; // µs
+    uint32_t maxJitter = 0;  // µs
+    uint64_t jitterSum = 0;  // µs
+    uint32_t jitterCount = 0;
+
+    void tick();
+
+    friend void coilTimer(void *arg);
+
+public:
+    ~XRTLcoilMotor();
+
+    bool begin(uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4);
+
+    void setMaxSpeed(float speed);
+    void setAcceleration(float accel);
+    void setCurrentPosition(long position);
+
+    void move(long relative);
+    void moveTo(long absolute);
+    void stop();
+
+    long currentPosition();
+    long targetPosition();
+    long distanceToGo();
+    bool isRunning();
+    uint32_t travelTime();
+
+    bool claim();
+    void release();
+    void step(bool forward);
+    bool stopRequested();
+
+    void setLimit(bool forward, bool reached);
+    bool atLimit(bool forward);
+
+    void enableOutputs();
+    void disableOutputs();
+
+    uint32_t jitter();
+    uint32_t peakJitter();
+    uint32_t meanJitter();
+    void resetJitter();
+};
+
+void coilTimer(void *arg);
+
+#endif
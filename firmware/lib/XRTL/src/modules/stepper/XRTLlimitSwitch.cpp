@@ -0,0 +1,61 @@
+#include "XRTLlimitSwitch.h"
+
+XRTLlimitSwitch::~XRTLlimitSwitch() {
+    end();
+}
+
+/**
+ * @brief interrupt service routine: pass the state of the switch to the motor
+ * @param arg pointer to the limit switch
+ * @note the level is read instead of inferred from the edge, bouncing contacts settle on the final state
+ */
+void IRAM_ATTR XRTLlimitSwitch::handleEdge(void *arg) {
+    XRTLlimitSwitch *limitSwitch = (XRTLlimitSwitch *)arg;
+    bool active = (digitalRead(limitSwitch->pin) == limitSwitch->activeLevel);
+    limitSwitch->motor->setLimit(limitSwitch->upperEnd, active);
+}
+
+/**
+ * @brief watch a switch and stop the motor once it is reached
+ * @param inputPin pin the switch is connected to
+ * @param activeHigh false: the pin reads low when the switch is reached (normally open contact), true: high (normally closed)
+ * @param upper true: switch at the upper end of the travel, false: at the lower end
+ * @param limitedMotor motor to stop, must exist as long as the switch is in use
+ */
+void XRTLlimitSwitch::begin(uint8_t inputPin, bool activeHigh, bool upper, XRTLmotor *limitedMotor) {
+    end();
+
+    pin = inputPin;
+    activeLevel = activeHigh ? HIGH : LOW;
+    upperEnd = upper;
+    motor = limitedMotor;
+
+    pinMode(pin, INPUT_PULLUP);
+    motor->setLimit(upperEnd, reached());
+    attachInterruptArg(pin, handleEdge, this, CHANGE);
+}
+
+/**
+ * @brief stop watching the switch, the motor is no longer blocked
+ */
+void XRTLlimitSwitch::end() {
+    if (!motor) return;
+    detachInterrupt(pin);
+    motor->setLimit(upperEnd, false);
+    motor = NULL;
+}
+
+/**
+ * @returns true if the switch is in use
+ */
+bool XRTLlimitSwitch::connected() {
+    return (motor != NULL);
+}
+
+/**
+ * @returns true if the switch is active
+ */
+bool XRTLlimitSwitch::reached() {
+    if (!motor) return false;
+    return (digitalRead(pin) == activeLevel);
+}
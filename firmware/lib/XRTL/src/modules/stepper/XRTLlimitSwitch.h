@@ -0,0 +1,29 @@
+#ifndef XRTLLIMITSWITCH_H
+#define XRTLLIMITSWITCH_H
+
+#include "XRTLmotor.h"
+
+// limit or home switch at one end of the travel of a stepper motor
+// the GPIO interrupt passes every change to the motor, which ends steps towards the switch within one step period.
+// The switch keeps blocking motion towards it as long as it is active, motion away from it remains possible.
+// The input uses the internal pull up: wire the switch to GND. Pins 34-39 have no pull up and need an external one.
+class XRTLlimitSwitch {
+private:
+    uint8_t pin = 255;
+    bool activeLevel = LOW;
+    bool upperEnd = false;
+    XRTLmotor *motor = NULL;
+
+    static void IRAM_ATTR handleEdge(void *arg);
+
+public:
+    ~XRTLlimitSwitch();
+
+    void begin(uint8_t inputPin, bool activeHigh, bool upper, XRTLmotor *limitedMotor);
+    void end();
+
+    bool connected();
+    bool reached();
+};
+
+#endif
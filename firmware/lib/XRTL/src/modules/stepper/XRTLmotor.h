@@ -0,0 +1,52 @@
+#ifndef XRTLMOTOR_H
+#define XRTLMOTOR_H
+
+#include "common/XRTLfunctions.h"
+#include "esp_timer.h"
+
+#define MOTOR_MIN_DELAY 10 // shortest delay between two timer calls in µs
+
+// common interface of the stepper motor drivers
+// steps are generated in the background, independent of the main loop. All methods are safe to call from the main loop.
+class XRTLmotor {
+public:
+    virtual ~XRTLmotor() {}
+
+    virtual void setMaxSpeed(float speed) = 0;
+    virtual void setAcceleration(float acceleration) = 0;
+    virtual void setCurrentPosition(long position) = 0;
+
+    virtual void move(long relative) = 0;
+    virtual void moveTo(long absolute) = 0;
+    virtual void stop() = 0;
+
+    virtual long currentPosition() = 0;
+    virtual long targetPosition() = 0;
+    virtual long distanceToGo() = 0;
+    virtual bool isRunning() = 0;
+    virtual uint32_t travelTime() = 0; // duration of the current move in ms
+
+    // step generation by a motion group
+    virtual bool claim() = 0;
+    virtual void release() = 0;
+    virtual void step(bool forward) = 0;     // starts the step, completed by endStep()
+    virtual void prepareStep(bool forward) {} // set the direction ahead of the following steps
+    virtual void endStep() {}                 // end the step pulse, drivers without pulses ignore this
+    virtual bool stopRequested() = 0;
+
+    // limit switches: steps towards a reached limit end within one step period, motion away from it remains possible
+    virtual void setLimit(bool forward, bool reached) = 0; // safe to call from an interrupt
+    virtual bool atLimit(bool forward) = 0;
+
+    virtual void enableOutputs() = 0;
+    virtual void disableOutputs() = 0;
+
+    // diagnostics, drivers without the respective measurement report 0
+    virtual uint32_t jitter() { return 0; }
+    virtual uint32_t peakJitter() { return 0; }
+    virtual uint32_t meanJitter() { return 0; }
+    virtual void resetJitter() {}
+    virtual long lostSteps() { return 0; }
+};
+
+#endif
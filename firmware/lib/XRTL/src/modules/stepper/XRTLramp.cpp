@@ -0,0 +1,211 @@
+#include "XRTLramp.h"
+#include <math.h>
+
+XRTLramp::~XRTLramp() {
+    free(table);
+}
+
+/**
+ * @brief set the limits of the profile and precompute the acceleration
+ * @param speed maximum speed; steps/s
+ * @param accel acceleration and deceleration; steps/s²
+ * @param ticksPerSecond unit of the intervals
+ * @returns false if the table could not be allocated, the intervals are computed per step then
+ * @note the table is only rebuilt if a value changed, must not be called during a move
+ */
+bool XRTLramp::configure(uint32_t speed, uint32_t accel, uint32_t ticksPerSecond) {
+    speed = (speed > 0) ? speed : 1;
+    accel = (accel > 0) ? accel : 1;
+    if (speed == maxSpeed && accel == acceleration && ticksPerSecond == tickFrequency) return (table != NULL);
+
+    maxSpeed = speed;
+    acceleration = accel;
+    tickFrequency = ticksPerSecond;
+    cruise = tickFrequency / maxSpeed;
+
+    uint64_t speedSquared = (uint64_t)maxSpeed * maxSpeed;
+    rampLength = (speedSquared + 2 * (uint64_t)acceleration - 1) / (2 * (uint64_t)acceleration); // s = v²/2a, rounded up
+
+    free(table);
+    tableLength = (rampLength < RAMP_TABLE_LENGTH) ? rampLength : RAMP_TABLE_LENGTH;
+    table = (uint32_t *)malloc(tableLength * sizeof(uint32_t));
+    if (!table) {
+        tableLength = 0;
+        return false;
+    }
+
+    for (uint32_t k = 1; k <= tableLength; k++) {
+        uint32_t rate = squareRoot(2 * (uint64_t)acceleration * k);
+        table[k - 1] = (rate < maxSpeed) ? tickFrequency / rate : cruise;
+    }
+    return true;
+}
+
+/**
+ * @brief start a move from rest
+ * @param steps distance of the move
+ */
+void XRTLramp::start(uint32_t steps) {
+    end = steps;
+    done = 0;
+    lastInterval = 0;
+    stopRequest = false;
+    abortRequest = false;
+}
+
+/**
+ * @brief brake as fast as the acceleration permits
+ * @note applied with the next step, safe to call while next() is used in an interrupt
+ */
+void XRTLramp::stop() {
+    stopRequest = true;
+}
+
+/**
+ * @brief end the move without braking, e.g. at a limit switch
+ * @note applied with the next step, safe to call from an interrupt
+ */
+void XRTLramp::abort() {
+    abortRequest = true;
+}
+
+/**
+ * @brief shorten the move to the braking distance, or end it right away after an abort
+ * @note the profile is symmetric: braking takes as many steps as the acceleration to the current speed
+ */
+void XRTLramp::halt() {
+    stopRequest = false;
+    if (abortRequest) {
+        abortRequest = false;
+        end = done;
+        return;
+    }
+
+    uint32_t remaining = end - done;
+    uint32_t brake = (done < remaining) ? done : remaining;
+    if (brake > rampLength) brake = rampLength;
+    end = done + brake;
+}
+
+/**
+ * @brief look up the interval between two steps
+ * @param fromStart steps performed, at least 1
+ * @param toEnd steps remaining, at least 1
+ * @returns interval in ticks
+ */
+uint32_t XRTLramp::interval(uint32_t fromStart, uint32_t toEnd) {
+    uint32_t k = (fromStart < toEnd) ? fromStart : toEnd; // distance to the closer end of the move
+    if (k >= rampLength) return cruise;
+    if (k <= tableLength) return table[k - 1];
+
+    return tickFrequency / squareRoot(2 * (uint64_t)acceleration * k);
+}
+
+/**
+ * @brief perform the next step
+ * @returns time until the following step in ticks, 0 after the last step
+ */
+uint32_t XRTLramp::next() {
+    if (stopRequest || abortRequest) halt();
+    if (done >= end) return 0;
+
+    done++;
+    if (done == end) return 0;
+
+    lastInterval = interval(done, end - done);
+    return lastInterval;
+}
+
+/**
+ * @returns true once all steps of the move are performed
+ */
+bool XRTLramp::finished() {
+    if (stopRequest || abortRequest) halt();
+    return (done >= end);
+}
+
+/**
+ * @returns steps performed since the start of the move
+ */
+uint32_t XRTLramp::performed() {
+    return done;
+}
+
+/**
+ * @returns total steps of the move, less than requested after a stop
+ */
+uint32_t XRTLramp::planned() {
+    return end;
+}
+
+/**
+ * @returns current speed; steps/s
+ */
+uint32_t XRTLramp::speed() {
+    if (lastInterval == 0) return 0;
+    return tickFrequency / lastInterval;
+}
+
+/**
+ * @brief time spent on the first steps of the acceleration
+ * @param steps number of intervals counted from rest
+ * @returns sum of the intervals in ticks
+ * @note the table part is summed exactly, the computed part beyond the table is integrated in closed form
+ * (Σ 1/√k ≈ 2√k evaluated at the midpoints), the cruising part is multiplied. Uses the FPU: not for interrupts.
+ * @note the integral stays within 0.1 % of the exact sum
+ */
+uint64_t XRTLramp::rampTime(uint32_t steps) {
+    uint64_t total = 0;
+    uint32_t accelerating = (steps < rampLength) ? steps : rampLength - 1; // intervals before the maximum speed is reached
+
+    uint32_t tabled = (accelerating < tableLength) ? accelerating : tableLength;
+    for (uint32_t k = 0; k < tabled; k++) {
+        total += table[k];
+    }
+
+    if (accelerating > tabled) {
+        double scale = (double)tickFrequency / sqrt(2.0 * acceleration);
+        double integral = scale * 2.0 * (sqrt(accelerating + 0.5) - sqrt(tabled + 0.5));
+        total += (uint64_t)(integral - 0.5 * (accelerating - tabled)); // the intervals are rounded down by half a tick on average
+    }
+
+    total += (uint64_t)(steps - accelerating) * cruise;
+    return total;
+}
+
+/**
+ * @brief time from the first to the last step of a move as generated by next()
+ * @param steps distance of the move
+ * @returns duration in ticks
+ * @note the profile is symmetric: every distance to the closer end of the move occurs twice, the middle once
+ */
+uint64_t XRTLramp::duration(uint32_t steps) {
+    if (steps < 2) return 0;
+
+    uint32_t half = (steps - 1) / 2;
+    uint64_t total = 2 * rampTime(half);
+    if (steps % 2 == 0) total += interval(half + 1, half + 1);
+    return total;
+}
+
+/**
+ * @brief integer square root, bit by bit
+ * @param value radicand
+ * @returns largest integer whose square does not exceed the value
+ */
+uint32_t XRTLramp::squareRoot(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) bit >>= 2;
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
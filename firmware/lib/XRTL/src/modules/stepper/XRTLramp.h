@@ -0,0 +1,53 @@
+#ifndef XRTLRAMP_H
+#define XRTLRAMP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define RAMP_TABLE_LENGTH 1024 // longest acceleration held in the table in steps, longer ramps are computed per step
+
+// trapezoidal speed profile of a move, stepping uses integer arithmetic only
+// the step intervals of the acceleration from rest (v² = 2as) are precomputed when speed or acceleration change.
+// Deceleration uses the same table counted from the end of the move, stepping costs a table lookup.
+// next() and stop() are safe to use in interrupts: the FPU must not be used there. The table must not be reconfigured during a move.
+// Does not depend on the hardware, the profile can be compiled and checked on the host.
+class XRTLramp {
+private:
+    uint32_t maxSpeed = 0;      // steps/s
+    uint32_t acceleration = 0;  // steps/s²
+    uint32_t tickFrequency = 0; // unit of the intervals; Hz
+
+    uint32_t *table = NULL;    // interval after k steps from rest at index k - 1; ticks
+    uint32_t tableLength = 0;  // entries of the table
+    uint32_t rampLength = 0;   // steps until the maximum speed is reached
+    uint32_t cruise = 0;       // interval at maximum speed; ticks
+
+    uint32_t end = 0;  // steps of the move, reduced by a stop
+    uint32_t done = 0; // steps performed
+    uint32_t lastInterval = 0;
+    volatile bool stopRequest = false;
+    volatile bool abortRequest = false;
+
+    uint32_t interval(uint32_t fromStart, uint32_t toEnd);
+    uint64_t rampTime(uint32_t steps);
+    void halt();
+
+public:
+    ~XRTLramp();
+
+    bool configure(uint32_t speed, uint32_t accel, uint32_t ticksPerSecond);
+    void start(uint32_t steps);
+    void stop();
+    void abort();
+
+    uint32_t next();
+    bool finished();
+    uint32_t performed();
+    uint32_t planned();
+    uint32_t speed();
+    uint64_t duration(uint32_t steps);
+
+    static uint32_t squareRoot(uint64_t value);
+};
+
+#endif
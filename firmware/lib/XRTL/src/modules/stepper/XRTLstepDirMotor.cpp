@@ -0,0 +1,451 @@
+#include "XRTLstepDirMotor.h"
+#include "esp_rom_gpio.h"
+#include "soc/gpio_periph.h"
+
+uint8_t XRTLstepDirMotor::rmtChannels = 0;
+uint8_t XRTLstepDirMotor::pcntUnits = 0;
+
+XRTLstepDirMotor::~XRTLstepDirMotor() {
+    if (channel != RMT_CHANNEL_MAX) {
+        rmt_tx_stop(channel);
+        rmt_driver_uninstall(channel);
+    }
+    if (unit != PCNT_UNIT_MAX) {
+        pcnt_counter_pause(unit);
+        pcnt_isr_handler_remove(unit);
+    }
+}
+
+/**
+ * @brief attach the driver and set up pulse generation and counting
+ * @param step step pin, a pulse per (micro)step
+ * @param dir direction pin, high: forward
+ * @param enable enable pin of the driver, active low; 255: not connected
+ * @returns true if an RMT channel and a PCNT unit could be set up
+ */
+bool XRTLstepDirMotor::begin(uint8_t step, uint8_t dir, uint8_t enable) {
+    stepPin = step;
+    dirPin = dir;
+    enablePin = enable;
+
+    if (rmtChannels >= RMT_CHANNEL_MAX || pcntUnits >= PCNT_UNIT_MAX) return false;
+    channel = (rmt_channel_t)(RMT_CHANNEL_MAX - 1 - rmtChannels++);
+    unit = (pcnt_unit_t)pcntUnits++;
+
+    if (enablePin != 255) {
+        pinMode(enablePin, OUTPUT);
+        digitalWrite(enablePin, HIGH); // disabled until a move starts
+    }
+
+    // count the pulses on the step pin: up while the direction pin is high, down while it is low
+    pcnt_config_t counter = {};
+    counter.pulse_gpio_num = stepPin;
+    counter.ctrl_gpio_num = dirPin;
+    counter.channel = PCNT_CHANNEL_0;
+    counter.unit = unit;
+    counter.pos_mode = PCNT_COUNT_INC;
+    counter.neg_mode = PCNT_COUNT_DIS;
+    counter.lctrl_mode = PCNT_MODE_REVERSE;
+    counter.hctrl_mode = PCNT_MODE_KEEP;
+    counter.counter_h_lim = STEPDIR_COUNT_LIMIT;
+    counter.counter_l_lim = -STEPDIR_COUNT_LIMIT;
+    if (pcnt_unit_config(&counter) != ESP_OK) return false;
+
+    pcnt_event_enable(unit, PCNT_EVT_H_LIM);
+    pcnt_event_enable(unit, PCNT_EVT_L_LIM);
+    pcnt_counter_pause(unit);
+    pcnt_counter_clear(unit);
+    pcnt_isr_service_install(0); // shared by all units, fails harmlessly if it is installed already
+    pcnt_isr_handler_add(unit, countOverflow, this);
+    pcnt_intr_enable(unit);
+    pcnt_counter_resume(unit);
+
+    // PCNT configured both pins as inputs: drive the direction pin again, the counter keeps reading it
+    gpio_set_direction((gpio_num_t)dirPin, GPIO_MODE_INPUT_OUTPUT);
+    gpio_set_level((gpio_num_t)dirPin, direction);
+
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)stepPin, channel);
+    config.clk_div = STEPDIR_CLOCK_DIVIDER;
+    config.mem_block_num = 1;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+    config.tx_config.idle_output_en = true;
+    if (rmt_config(&config) != ESP_OK) return false;
+    if (rmt_driver_install(channel, 0, 0) != ESP_OK) return false;
+    rmt_translator_init(channel, stepTranslator);
+    rmt_translator_set_context(channel, this);
+    gpio_set_level((gpio_num_t)stepPin, 0); // level of the pin while it is disconnected from the RMT
+    connectPulses();
+
+    return true;
+}
+
+/**
+ * @brief route the step pin to the RMT channel
+ * @note the input of the pin stays enabled for the pulse counter
+ */
+void XRTLstepDirMotor::connectPulses() {
+    rmt_set_gpio(channel, RMT_MODE_TX, (gpio_num_t)stepPin, false);
+    PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[stepPin]);
+}
+
+/**
+ * @brief RMT translator, forwards to the motor
+ * @note the source holds one dummy byte per step, the pulses are taken from the ramp of the motor
+ */
+void stepTranslator(const void *src, rmt_item32_t *dest, size_t srcSize, size_t wantedNum, size_t *translatedSize, size_t *itemNum) {
+    XRTLstepDirMotor *motor = NULL;
+    rmt_translator_get_context(itemNum, (void **)&motor);
+    motor->translate(dest, srcSize, wantedNum, translatedSize, itemNum);
+}
+
+/**
+ * @brief fill RMT items with the next step pulses
+ * @param dest items to fill
+ * @param stepCount steps left in the source
+ * @param wantedItems number of items requested by the driver
+ * @param translatedSteps receives the number of steps started
+ * @param itemCount receives the number of filled items
+ * @note runs in the RMT interrupt, apart from the first call: integer arithmetic only
+ */
+void XRTLstepDirMotor::translate(rmt_item32_t *dest, size_t stepCount, size_t wantedItems, size_t *translatedSteps, size_t *itemCount) {
+    size_t steps = 0;
+    size_t items = 0;
+
+    while (items < wantedItems) {
+        if (pendingLow == 0) {
+            if (steps == stepCount || ramp.finished()) break;
+
+            // one item per step: the pulse followed by as much of the interval as fits
+            uint32_t interval = ramp.next();
+            uint32_t low = (interval > 2 * STEPDIR_PULSE_WIDTH) ? interval - STEPDIR_PULSE_WIDTH : STEPDIR_PULSE_WIDTH;
+            dest[items].level0 = 1;
+            dest[items].duration0 = STEPDIR_PULSE_WIDTH;
+            dest[items].level1 = 0;
+            dest[items].duration1 = min(low, (uint32_t)STEPDIR_MAX_DURATION);
+            pendingLow = low - dest[items].duration1;
+            steps++;
+            items++;
+            continue;
+        }
+
+        // slow steps: continue the low level with further items, a duration of 0 would end the transmission
+        uint32_t first = min(pendingLow, (uint32_t)STEPDIR_MAX_DURATION);
+        if (first == pendingLow) first = (pendingLow + 1) / 2;
+        uint32_t second = min(pendingLow - first, (uint32_t)STEPDIR_MAX_DURATION);
+        if (second == 0) second = 1;
+        dest[items].level0 = 0;
+        dest[items].duration0 = first;
+        dest[items].level1 = 0;
+        dest[items].duration1 = second;
+        pendingLow -= min(pendingLow, first + second);
+        items++;
+    }
+
+    if (pendingLow == 0 && ramp.finished()) steps = stepCount; // consume the source after a stop to end the transmission
+    *translatedSteps = steps;
+    *itemCount = items;
+}
+
+/**
+ * @brief PCNT limit event, folds the counter into the overflow
+ * @param arg pointer to the XRTLstepDirMotor
+ */
+void countOverflow(void *arg) {
+    XRTLstepDirMotor *motor = (XRTLstepDirMotor *)arg;
+    uint32_t status = 0;
+    pcnt_get_event_status(motor->unit, &status);
+    if (status & PCNT_EVT_H_LIM) motor->overflow += STEPDIR_COUNT_LIMIT;
+    if (status & PCNT_EVT_L_LIM) motor->overflow -= STEPDIR_COUNT_LIMIT;
+}
+
+/**
+ * @returns pulses counted since start up, down counts included
+ */
+long XRTLstepDirMotor::counted() {
+    long before = 0;
+    long after = 0;
+    int16_t count = 0;
+    do { // the overflow might change while reading
+        before = overflow;
+        pcnt_get_counter_value(unit, &count);
+        after = overflow;
+    } while (before != after);
+    return before + count;
+}
+
+/**
+ * @brief check whether the RMT is still sending the move
+ * @returns true while the move is running
+ * @note concludes the move once the transmission is complete
+ */
+bool XRTLstepDirMotor::update() {
+    if (!transmitting) return false;
+    if (rmt_wait_tx_done(channel, 0) != ESP_OK) return true;
+
+    if (cut) { // pulses after the limit were not sent, the count is the position
+        connectPulses();
+        long position = currentPosition();
+        portENTER_CRITICAL(&motorMux);
+        transmitting = false;
+        commanded = position;
+        cut = false;
+        portEXIT_CRITICAL(&motorMux);
+        return false;
+    }
+
+    portENTER_CRITICAL(&motorMux);
+    transmitting = false;
+    commanded = moveStart + (direction ? 1 : -1) * (long)ramp.performed();
+    portEXIT_CRITICAL(&motorMux);
+    return false;
+}
+
+/**
+ * @brief set the direction pin
+ * @param forwards true: towards higher positions
+ * @note waits for the setup time of the driver after a change
+ */
+void XRTLstepDirMotor::setDirection(bool forwards) {
+    if (forwards == direction) return;
+
+    direction = forwards;
+    gpio_set_level((gpio_num_t)dirPin, direction);
+    delayMicroseconds(STEPDIR_DIR_SETUP);
+}
+
+/**
+ * @param speed maximum speed; steps/s
+ * @note applies to the next move
+ */
+void XRTLstepDirMotor::setMaxSpeed(float speed) {
+    maxSpeed = max(lroundf(speed), 1L);
+}
+
+/**
+ * @param accel acceleration; steps/s²
+ * @note applies to the next move
+ */
+void XRTLstepDirMotor::setAcceleration(float accel) {
+    acceleration = max(lroundf(accel), 1L);
+}
+
+/**
+ * @brief redefine the current position
+ * @param position new position in steps
+ * @note ignored while moving
+ */
+void XRTLstepDirMotor::setCurrentPosition(long position) {
+    if (update() || grouped) return;
+
+    long count = counted();
+    portENTER_CRITICAL(&motorMux);
+    origin = position - count;
+    commanded = position;
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @brief move relative to the current position
+ * @param relative distance in steps
+ */
+void XRTLstepDirMotor::move(long relative) {
+    moveTo(currentPosition() + relative);
+}
+
+/**
+ * @brief move to an absolute position
+ * @param absolute target position in steps
+ * @note ignored while moving: a running move can only be stopped
+ * @note ignored if the limit switch in the direction of the move is reached
+ */
+void XRTLstepDirMotor::moveTo(long absolute) {
+    if (update() || grouped) return;
+
+    long start = currentPosition();
+    long distance = absolute - start;
+    if (distance == 0 || limit[distance > 0]) return;
+
+    setDirection(distance > 0);
+    ramp.configure(maxSpeed, acceleration, STEPDIR_TICK_FREQUENCY); // rebuilds the table only after a change
+    ramp.start(labs(distance));
+    pendingLow = 0;
+    moveStart = start;
+    commanded = start;
+    transmitting = true;
+
+    // the translator takes the steps from the ramp, the source is a dummy of one byte per step
+    rmt_write_sample(channel, (const uint8_t *)this, labs(distance), false);
+}
+
+/**
+ * @brief decelerate to a stop as fast as the acceleration permits
+ * @note returns immediately, while grouped the request is passed on to the motion group
+ */
+void XRTLstepDirMotor::stop() {
+    portENTER_CRITICAL(&motorMux);
+    if (grouped) {
+        haltRequest = true;
+    } else {
+        ramp.stop();
+    }
+    portEXIT_CRITICAL(&motorMux);
+}
+
+/**
+ * @returns position counted by the PCNT unit
+ */
+long XRTLstepDirMotor::currentPosition() {
+    return origin + counted();
+}
+
+long XRTLstepDirMotor::targetPosition() {
+    if (!update()) return commanded;
+    return moveStart + (direction ? 1 : -1) * (long)ramp.planned();
+}
+
+long XRTLstepDirMotor::distanceToGo() {
+    return targetPosition() - currentPosition();
+}
+
+/**
+ * @returns true while a move is sent or a motion group controls the motor
+ */
+bool XRTLstepDirMotor::isRunning() {
+    return update() || grouped;
+}
+
+/**
+ * @returns duration of the running move in ms, 0 at rest
+ */
+uint32_t XRTLstepDirMotor::travelTime() {
+    if (!update()) return 0;
+    return ramp.duration(ramp.planned()) / (STEPDIR_TICK_FREQUENCY / 1000);
+}
+
+/**
+ * @brief hand the step generation over to a motion group
+ * @returns false if the motor is moving or already part of a group
+ * @note the step pin is driven as GPIO until release() is called
+ */
+bool XRTLstepDirMotor::claim() {
+    if (update()) return false;
+
+    portENTER_CRITICAL(&motorMux);
+    bool available = !grouped;
+    if (available) {
+        grouped = true;
+        haltRequest = false;
+    }
+    portEXIT_CRITICAL(&motorMux);
+    if (!available) return false;
+
+    gpio_set_level((gpio_num_t)stepPin, 0);
+    esp_rom_gpio_connect_out_signal(stepPin, SIG_GPIO_OUT_IDX, false, false);
+    return true;
+}
+
+/**
+ * @brief return the step generation to the RMT
+ */
+void XRTLstepDirMotor::release() {
+    portENTER_CRITICAL(&motorMux);
+    bool wasGrouped = grouped;
+    grouped = false;
+    haltRequest = false;
+    portEXIT_CRITICAL(&motorMux);
+
+    if (!wasGrouped) return;
+    gpio_set_level((gpio_num_t)stepPin, 0); // a limit switch routes the pin back to this level
+    connectPulses();
+}
+
+/**
+ * @brief start a step pulse immediately
+ * @param forward true: step towards higher positions
+ * @note only valid while claimed by a motion group, the pulse lasts until endStep()
+ * @note a step towards a reached limit switch is dropped and requests the group to stop
+ */
+void XRTLstepDirMotor::step(bool forward) {
+    if (!grouped) return;
+    if (limit[forward]) {
+        portENTER_CRITICAL(&motorMux);
+        haltRequest = true;
+        portEXIT_CRITICAL(&motorMux);
+        return;
+    }
+
+    prepareStep(forward); // no change if the group set the direction ahead, as it should
+    gpio_set_level((gpio_num_t)stepPin, 1);
+    commanded += forward ? 1 : -1;
+}
+
+/**
+ * @brief set the direction pin for the following steps
+ * @param forward true: towards higher positions
+ * @note does not wait: the group leaves the setup time of the driver before the next step
+ */
+void XRTLstepDirMotor::prepareStep(bool forward) {
+    if (!grouped || forward == direction) return;
+
+    direction = forward;
+    gpio_set_level((gpio_num_t)dirPin, direction);
+}
+
+/**
+ * @brief end the pulse started by step()
+ */
+void XRTLstepDirMotor::endStep() {
+    if (grouped) gpio_set_level((gpio_num_t)stepPin, 0);
+}
+
+/**
+ * @returns true once if stop() was called while grouped
+ */
+bool XRTLstepDirMotor::stopRequested() {
+    portENTER_CRITICAL(&motorMux);
+    bool requested = haltRequest;
+    haltRequest = false;
+    portEXIT_CRITICAL(&motorMux);
+    return requested;
+}
+
+/**
+ * @brief report the state of a limit switch
+ * @param forward true: switch at the upper end
+ * @param reached true: the switch is active
+ * @note called from the interrupt of the switch: a running move towards the switch is cut off at once by routing
+ * the step pin back to its GPIO level, the RMT finishes the transmission in the background
+ */
+void XRTLstepDirMotor::setLimit(bool forward, bool reached) {
+    limit[forward] = reached;
+    if (!reached || !transmitting || cut || forward != direction) return;
+
+    esp_rom_gpio_connect_out_signal(stepPin, SIG_GPIO_OUT_IDX, false, false);
+    ramp.abort();
+    cut = true;
+}
+
+/**
+ * @param forward true: switch at the upper end
+ * @returns true if the limit switch is reached
+ */
+bool XRTLstepDirMotor::atLimit(bool forward) {
+    return limit[forward];
+}
+
+void XRTLstepDirMotor::enableOutputs() {
+    if (enablePin != 255) digitalWrite(enablePin, LOW);
+}
+
+void XRTLstepDirMotor::disableOutputs() {
+    if (enablePin != 255) digitalWrite(enablePin, HIGH);
+}
+
+/**
+ * @returns difference between generated and counted steps, the position follows the count
+ * @note only evaluated at rest
+ */
+long XRTLstepDirMotor::lostSteps() {
+    if (isRunning()) return 0;
+    return commanded - currentPosition();
+}
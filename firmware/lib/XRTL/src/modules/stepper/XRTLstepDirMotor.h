@@ -0,0 +1,99 @@
+#ifndef XRTLSTEPDIRMOTOR_H
+#define XRTLSTEPDIRMOTOR_H
+
+#include "XRTLmotor.h"
+#include "XRTLramp.h"
+#include "driver/pcnt.h"
+#include "driver/rmt.h"
+
+#define STEPDIR_CLOCK_DIVIDER 8         // RMT tick: 80 MHz APB clock / 8 = 0.1 µs
+#define STEPDIR_TICK_FREQUENCY 10000000 // Hz
+#define STEPDIR_PULSE_WIDTH 30          // high time of a step pulse in ticks (3 µs), suits common drivers (A4988, DRV8825, TMC)
+#define STEPDIR_MAX_DURATION 32767      // longest level of an RMT item in ticks
+#define STEPDIR_DIR_SETUP 5             // delay between a change of direction and the next step pulse in µs
+#define STEPDIR_COUNT_LIMIT 30000       // the pulse counter is folded into the position at ± this value
+
+// stepper motor connected to an external driver by step and direction pin, e.g. for microstepping drivers
+// the step pulses of a move are generated by the RMT peripheral: a translator fills the RMT memory with one pulse
+// per step, timed by the integer ramp. The CPU is only involved when half the RMT memory has been sent.
+// The pulses are counted back by a PCNT unit (up or down by the direction pin) which provides the position
+// and verifies the pulse generation. A limit switch disconnects the step pin from the RMT right away, the position
+// follows the pulses that actually reached the pin.
+class XRTLstepDirMotor : public XRTLmotor {
+private:
+    static uint8_t rmtChannels; // RMT channels in use, allocated from the top: NeoPixels use the lowest channels
+    static uint8_t pcntUnits;   // PCNT units in use
+
+    uint8_t stepPin = 255;
+    uint8_t dirPin = 255;
+    uint8_t enablePin = 255; // active low, 255: unused
+
+    rmt_channel_t channel = RMT_CHANNEL_MAX;
+    pcnt_unit_t unit = PCNT_UNIT_MAX;
+    portMUX_TYPE motorMux = portMUX_INITIALIZER_UNLOCKED;
+
+    XRTLramp ramp;
+    uint32_t maxSpeed = 500;     // steps/s
+    uint32_t acceleration = 500; // steps/s²
+    uint32_t pendingLow = 0;     // rest of the interval that did not fit into the last RMT item; ticks
+
+    bool transmitting = false;  // a move is sent by the RMT
+    bool direction = true;      // level of the direction pin
+    long moveStart = 0;         // position at the start of the move
+    long commanded = 0;         // position according to the generated steps, updated at the end of a move
+    long origin = 0;            // position at a count of 0
+    volatile long overflow = 0; // counts folded by the PCNT limit events
+
+    bool grouped = false;     // steps are generated by a motion group instead of the RMT
+    bool haltRequest = false; // stop requested while grouped, handled by the motion group
+    volatile bool limit[2] = {false, false}; // limit switch reached: lower, upper
+    volatile bool cut = false;               // step pin disconnected from the RMT by a limit switch
+
+    long counted();
+    bool update();
+    void setDirection(bool forwards);
+    void connectPulses();
+    void translate(rmt_item32_t *dest, size_t stepCount, size_t wantedItems, size_t *translatedSteps, size_t *itemCount);
+
+    friend void stepTranslator(const void *src, rmt_item32_t *dest, size_t srcSize, size_t wantedNum, size_t *translatedSize, size_t *itemNum);
+    friend void countOverflow(void *arg);
+
+public:
+    ~XRTLstepDirMotor();
+
+    bool begin(uint8_t step, uint8_t dir, uint8_t enable);
+
+    void setMaxSpeed(float speed);
+    void setAcceleration(float accel);
+    void setCurrentPosition(long position);
+
+    void move(long relative);
+    void moveTo(long absolute);
+    void stop();
+
+    long currentPosition();
+    long targetPosition();
+    long distanceToGo();
+    bool isRunning();
+    uint32_t travelTime();
+
+    bool claim();
+    void release();
+    void step(bool forward);
+    void prepareStep(bool forward);
+    void endStep();
+    bool stopRequested();
+
+    void setLimit(bool forward, bool reached);
+    bool atLimit(bool forward);
+
+    void enableOutputs();
+    void disableOutputs();
+
+    long lostSteps();
+};
+
+void stepTranslator(const void *src, rmt_item32_t *dest, size_t srcSize, size_t wantedNum, size_t *translatedSize, size_t *itemNum);
+void countOverflow(void *arg);
+
+#endif
@@ -12,6 +12,10 @@ WifiModule::WifiModule(String moduleName) {
     parameters.addDependent(anonymous, "anonymous", "String", "enterprise", true); // anonymous identity only needed with enterprise WiFi
 }
 
+moduleType WifiModule::getType() {
+    return type;
+}
+
 void WiFiStationDisconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
     WiFi.reconnect();
 }
@@ -20,6 +20,7 @@ private:
 public:
     WifiModule(String moduleName);
     moduleType type = xrtl_wifi;
+    moduleType getType();
 
     void saveSettings(JsonObject &settings);
     void loadSettings(JsonObject &settings);
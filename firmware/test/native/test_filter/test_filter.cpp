@@ -0,0 +1,206 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include "modules/input/XRTLfilter.cpp"
+
+#define SIGNAL_LENGTH 20000
+#define BENCHMARK_RUNS 20
+
+static uint32_t noiseState = 12345;
+
+/**
+ * @returns uniformly distributed noise in [-1, 1), reproducible between runs
+ */
+static double noise() {
+    noiseState = noiseState * 1664525 + 1013904223;
+    return ((double)(noiseState >> 8) / (1 << 24)) * 2.0 - 1.0;
+}
+
+/**
+ * @brief synthesize an input: DC, a slow sine, a step and noise
+ * @param samples receives SIGNAL_LENGTH samples; mV (Q4)
+ */
+static void synthesize(uint16_t *samples) {
+    for (uint32_t n = 0; n < SIGNAL_LENGTH; n++) {
+        double milliVolts = 1200.0 + 300.0 * sin(2.0 * M_PI * n / 3000.0) + 50.0 * noise();
+        if (n > SIGNAL_LENGTH / 2) milliVolts += 800.0;
+        samples[n] = (uint16_t)lround(milliVolts * (1 << FILTER_FRACTION));
+    }
+}
+
+/**
+ * @brief filter the input as documented for XRTLfilter, in floating point
+ * @param kernel filter kernel
+ * @param length window length in samples
+ * @param samples input; mV (Q4)
+ * @param reference receives SIGNAL_LENGTH outputs; mV
+ * @note the filter starts from reset(samples[0]) just as the tested one
+ */
+static void filterReference(filter_t kernel, uint16_t length, const uint16_t *samples, double *reference) {
+    double first = (double)samples[0] / (1 << FILTER_FRACTION);
+    double alpha = 2.0 / (length + 1);
+
+    // biquad: same Butterworth design as XRTLfilter::configure(), coefficients unquantized
+    double w0 = 2.0 * M_PI * std::min(0.443 / length, 0.4);
+    double alphaQ = sin(w0) / sqrt(2.0);
+    double a0 = 1.0 + alphaQ;
+    double b0 = (1.0 - cos(w0)) / 2.0 / a0;
+    double b1 = (1.0 - cos(w0)) / a0;
+    double a1 = -2.0 * cos(w0) / a0;
+    double a2 = (1.0 - alphaQ) / a0;
+    double x1 = first, x2 = first, y1 = first, y2 = first;
+
+    double output = first;
+    for (uint32_t n = 0; n < SIGNAL_LENGTH; n++) {
+        double x = (double)samples[n] / (1 << FILTER_FRACTION);
+        switch (kernel) {
+        case moving_average:
+        case median: {
+            std::vector<uint16_t> window;
+            for (int32_t k = (int32_t)n - length + 1; k <= (int32_t)n; k++) {
+                window.push_back(samples[std::max(k, 0)]);
+            }
+            if (kernel == moving_average) {
+                double sum = 0.0;
+                for (uint16_t sample : window) sum += sample;
+                output = sum / length / (1 << FILTER_FRACTION);
+            } else {
+                std::sort(window.begin(), window.end());
+                uint32_t middle = window[length / 2];
+                if (length % 2 == 0) middle = (middle + window[length / 2 - 1]) / 2; // Q4 resolution as on the device
+                output = (double)middle / (1 << FILTER_FRACTION);
+            }
+            break;
+        }
+        case exponential:
+            output += alpha * (x - output);
+            break;
+        case biquad:
+            output = b0 * x + b1 * x1 + b0 * x2 - a1 * y1 - a2 * y2;
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = output;
+            break;
+        }
+        reference[n] = output;
+    }
+}
+
+/**
+ * @brief run the fixed-point filter over the input and compare it to the reference
+ * @param kernel filter kernel
+ * @param length window length in samples
+ * @param tolerance largest deviation permitted; mV
+ */
+static void compare(filter_t kernel, uint16_t length, double tolerance) {
+    static uint16_t samples[SIGNAL_LENGTH];
+    static double reference[SIGNAL_LENGTH];
+    synthesize(samples);
+    filterReference(kernel, length, samples, reference);
+
+    XRTLfilter filter;
+    filter.configure(kernel, length);
+    filter.reset(samples[0]);
+    double worst = 0.0;
+    for (uint32_t n = 0; n < SIGNAL_LENGTH; n++) {
+        filter.push(samples[n]);
+        worst = std::max(worst, fabs(filter.read() - reference[n]));
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "%s %u: worst deviation %.4f mV", filterName[kernel], length, worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= tolerance);
+}
+
+void test_configure_constrains_length() {
+    TEST_ASSERT_EQUAL(FILTER_MAX_LENGTH, XRTLfilter::maxLength(moving_average));
+    TEST_ASSERT_EQUAL(FILTER_MEDIAN_LENGTH, XRTLfilter::maxLength(median));
+
+    // a constant input passes unchanged at every length, including the constrained ones
+    const filter_t kernels[] = {moving_average, exponential, median, biquad};
+    const uint16_t lengths[] = {0, 1, 2, 100, 5000};
+    for (filter_t kernel : kernels) {
+        for (uint16_t length : lengths) {
+            XRTLfilter filter;
+            filter.configure(kernel, length);
+            filter.reset(1000 << FILTER_FRACTION);
+            for (int n = 0; n < 100; n++) {
+                filter.push(1000 << FILTER_FRACTION);
+            }
+            TEST_ASSERT_FLOAT_WITHIN(0.01, 1000.0, filter.read());
+        }
+    }
+}
+
+void test_moving_average() {
+    // exact up to the Q16 output
+    compare(moving_average, 1, 0.001);
+    compare(moving_average, 16, 0.001);
+    compare(moving_average, FILTER_MAX_LENGTH, 0.001);
+}
+
+void test_exponential() {
+    // the Q16 state rounds down with every update, the bias grows with the time constant
+    compare(exponential, 1, 0.001);
+    compare(exponential, 16, 0.001);
+    compare(exponential, FILTER_MAX_LENGTH, 0.01);
+}
+
+void test_median() {
+    compare(median, 1, 0.001);
+    compare(median, 16, 0.001);
+    compare(median, FILTER_MEDIAN_LENGTH, 0.001);
+}
+
+void test_biquad() {
+    // the Q30 coefficients shift the poles of long windows slightly
+    compare(biquad, 1, 0.001);
+    compare(biquad, 16, 0.01);
+    compare(biquad, FILTER_MAX_LENGTH, 0.2);
+}
+
+void test_benchmark() {
+    static uint16_t samples[SIGNAL_LENGTH];
+    synthesize(samples);
+
+    const filter_t kernels[] = {moving_average, exponential, median, biquad};
+    for (filter_t kernel : kernels) {
+        XRTLfilter filter;
+        filter.configure(kernel, XRTLfilter::maxLength(kernel));
+        filter.reset(samples[0]);
+
+        // the output is read back to keep the loop from being optimized away
+        volatile double sink = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCHMARK_RUNS; i++) {
+            for (uint32_t n = 0; n < SIGNAL_LENGTH; n++) {
+                filter.push(samples[n]);
+            }
+            sink = sink + filter.read();
+        }
+        std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+        // host time only, the median is the worst case on the device as well: O(n) per sample
+        char message[64];
+        snprintf(message, sizeof(message), "%s %u: %.1f ns per sample", filterName[kernel], XRTLfilter::maxLength(kernel),
+                 std::chrono::duration<double, std::nano>(elapsed).count() / (BENCHMARK_RUNS * SIGNAL_LENGTH));
+        TEST_MESSAGE(message);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_configure_constrains_length);
+    RUN_TEST(test_moving_average);
+    RUN_TEST(test_exponential);
+    RUN_TEST(test_median);
+    RUN_TEST(test_biquad);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
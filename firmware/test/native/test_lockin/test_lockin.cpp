@@ -0,0 +1,104 @@
+#include <unity.h>
+
+#include "modules/input/XRTLlockIn.cpp"
+
+#define SAMPLE_RATE 20000.0 // Hz
+#define REFERENCE 137.0     // Hz, not a multiple of the filter rate or the pickup
+
+static uint32_t noiseState = 12345;
+
+/**
+ * @returns uniformly distributed noise in [-1, 1), reproducible between runs
+ */
+static double noise() {
+    noiseState = noiseState * 1664525 + 1013904223;
+    return ((double)(noiseState >> 8) / (1 << 24)) * 2.0 - 1.0;
+}
+
+/**
+ * @brief feed a synthetic signal into the lock-in
+ * @param lockIn demodulator, configured and reset
+ * @param seconds duration of the signal
+ * @param amplitude amplitude of the component at the reference frequency; mV
+ * @param phase phase of that component relative to the reference; degrees
+ * @param dc constant offset; mV
+ * @param pickup amplitude of 50 Hz pickup; mV
+ * @param noiseLevel peak amplitude of uniform noise; mV
+ */
+static void feed(XRTLlockIn &lockIn, double seconds, double amplitude, double phase, double dc, double pickup, double noiseLevel) {
+    uint32_t count = seconds * SAMPLE_RATE;
+    for (uint32_t n = 0; n < count; n++) {
+        double t = n / SAMPLE_RATE;
+        double milliVolts = dc + amplitude * cos(2.0 * M_PI * REFERENCE * t + phase * M_PI / 180.0);
+        milliVolts += pickup * sin(2.0 * M_PI * 50.0 * t) + noiseLevel * noise();
+        lockIn.push((uint16_t)lround(milliVolts * (1 << LOCKIN_FRACTION)));
+    }
+}
+
+void test_rejects_reference_above_nyquist() {
+    XRTLlockIn lockIn;
+    TEST_ASSERT_FALSE(lockIn.configure(SAMPLE_RATE / 2, SAMPLE_RATE, 0.1));
+    TEST_ASSERT_FALSE(lockIn.configure(0.0, SAMPLE_RATE, 0.1));
+    TEST_ASSERT_TRUE(lockIn.configure(REFERENCE, SAMPLE_RATE, 0.1));
+}
+
+void test_recovers_amplitude_and_phase() {
+    const double phases[] = {0.0, 45.0, 135.0, -90.0, -170.0};
+    for (double phase : phases) {
+        XRTLlockIn lockIn;
+        lockIn.configure(REFERENCE, SAMPLE_RATE, 0.1);
+        lockIn.reset(0.0);
+        feed(lockIn, 2.0, 200.0, phase, 1000.0, 0.0, 0.0);
+
+        TEST_ASSERT_FLOAT_WITHIN(0.2, 200.0, lockIn.amplitude());
+        TEST_ASSERT_FLOAT_WITHIN(0.5, phase, lockIn.phaseDegrees());
+    }
+}
+
+void test_rejects_dc_pickup_and_noise() {
+    XRTLlockIn lockIn;
+    lockIn.configure(REFERENCE, SAMPLE_RATE, 0.5);
+    lockIn.reset(0.0);
+    feed(lockIn, 8.0, 20.0, 30.0, 1500.0, 100.0, 10.0);
+
+    // the remaining noise is about 0.05 mV
+    TEST_ASSERT_FLOAT_WITHIN(0.2, 20.0, lockIn.amplitude());
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 30.0, lockIn.phaseDegrees());
+}
+
+void test_phase_follows_reset() {
+    XRTLlockIn lockIn;
+    lockIn.configure(REFERENCE, SAMPLE_RATE, 0.1);
+    lockIn.reset(0.25); // reference a quarter turn ahead of the signal
+    feed(lockIn, 2.0, 200.0, 0.0, 1000.0, 0.0, 0.0);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.5, -90.0, lockIn.phaseDegrees());
+}
+
+void test_square_wave_fundamental() {
+    XRTLlockIn lockIn;
+    lockIn.configure(REFERENCE, SAMPLE_RATE, 0.1);
+    lockIn.reset(0.0);
+
+    // square wave between 0 and 3300 mV, in phase with the reference
+    uint32_t count = 2.0 * SAMPLE_RATE;
+    for (uint32_t n = 0; n < count; n++) {
+        double turn = REFERENCE * n / SAMPLE_RATE + 0.25;
+        double milliVolts = (turn - floor(turn) < 0.5) ? 3300.0 : 0.0;
+        lockIn.push((uint16_t)lround(milliVolts * (1 << LOCKIN_FRACTION)));
+    }
+
+    double expected = 2.0 * 3300.0 / M_PI;
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.002, expected, lockIn.amplitude());
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 0.0, lockIn.phaseDegrees());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_reference_above_nyquist);
+    RUN_TEST(test_recovers_amplitude_and_phase);
+    RUN_TEST(test_rejects_dc_pickup_and_noise);
+    RUN_TEST(test_phase_follows_reset);
+    RUN_TEST(test_square_wave_fundamental);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+
+#include "modules/stepper/XRTLramp.cpp"
+
+#define TICKS 1000000 // µs
+#define BENCHMARK_RUNS 100
+
+/**
+ * @brief step a move to its end
+ * @param ramp started move
+ * @param steps receives the number of steps performed by the calls
+ * @returns sum of the intervals between the steps; ticks
+ */
+static uint64_t run(XRTLramp &ramp, uint32_t &steps) {
+    uint64_t total = 0;
+    steps = 0;
+    while (!ramp.finished()) {
+        total += ramp.next();
+        steps++;
+    }
+    return total;
+}
+
+void test_square_root() {
+    TEST_ASSERT_EQUAL(0, XRTLramp::squareRoot(0));
+    TEST_ASSERT_EQUAL(1, XRTLramp::squareRoot(3));
+    TEST_ASSERT_EQUAL(2, XRTLramp::squareRoot(4));
+    TEST_ASSERT_EQUAL(99999, XRTLramp::squareRoot(9999999999ULL));
+    TEST_ASSERT_EQUAL(100000, XRTLramp::squareRoot(10000000000ULL));
+    TEST_ASSERT_EQUAL(4294967295UL, XRTLramp::squareRoot(0xFFFFFFFFFFFFFFFFULL));
+}
+
+void test_duration_matches_steps() {
+    // ramps within the table, beyond the table and of a single step
+    const uint32_t limits[][2] = {{2000, 4000}, {20000, 50000}, {40000, 100000}, {1, 1}};
+    const uint32_t moves[] = {2, 3, 10, 501, 1000, 2048, 5000, 20001};
+    for (auto &limit : limits) {
+        XRTLramp ramp;
+        ramp.configure(limit[0], limit[1], TICKS);
+        for (uint32_t move : moves) {
+            ramp.start(move);
+            uint32_t steps;
+            uint64_t total = run(ramp, steps);
+            TEST_ASSERT_EQUAL(move, steps);
+            TEST_ASSERT_EQUAL(move, ramp.performed());
+
+            // the duration integrates the intervals beyond the table, documented to stay within 0.1 %
+            uint64_t expected = ramp.duration(move);
+            TEST_ASSERT_FLOAT_WITHIN(total * 0.001 + 1.0, (double)total, (double)expected);
+        }
+    }
+}
+
+void test_stop_brakes_from_cruise() {
+    XRTLramp ramp;
+    ramp.configure(2000, 4000, TICKS); // reaches 2000 steps/s after 500 steps
+    ramp.start(5000);
+    for (uint32_t k = 0; k < 1500; k++) {
+        ramp.next();
+    }
+    TEST_ASSERT_EQUAL(2000, ramp.speed());
+
+    ramp.stop();
+    TEST_ASSERT_FALSE(ramp.finished());
+    TEST_ASSERT_EQUAL(2000, ramp.planned()); // braking takes as many steps as the acceleration
+
+    // the speed never increases while braking and ends where the acceleration started
+    uint32_t lastSpeed = ramp.speed();
+    uint32_t interval = 0;
+    uint32_t braking = 0;
+    while (!ramp.finished()) {
+        uint32_t following = ramp.next();
+        braking++;
+        if (following == 0) break;
+        interval = following;
+        TEST_ASSERT_TRUE(ramp.speed() <= lastSpeed);
+        lastSpeed = ramp.speed();
+    }
+    TEST_ASSERT_EQUAL(500, braking);
+    TEST_ASSERT_EQUAL(2000, ramp.performed());
+    TEST_ASSERT_EQUAL(TICKS / XRTLramp::squareRoot(2 * 4000), interval); // last interval: one step from rest
+}
+
+void test_stop_while_accelerating() {
+    XRTLramp ramp;
+    ramp.configure(2000, 4000, TICKS);
+    ramp.start(5000);
+    for (uint32_t k = 0; k < 200; k++) {
+        ramp.next();
+    }
+    ramp.stop();
+    uint32_t steps;
+    run(ramp, steps);
+    TEST_ASSERT_EQUAL(200, steps); // brakes over the distance accelerated so far
+    TEST_ASSERT_EQUAL(400, ramp.performed());
+}
+
+void test_short_move_never_cruises() {
+    XRTLramp ramp;
+    ramp.configure(2000, 4000, TICKS);
+    ramp.start(300); // shorter than the 1000 steps needed to reach and leave the maximum speed
+
+    uint32_t intervals[300];
+    uint32_t peak = 0;
+    for (uint32_t k = 0; k < 300; k++) {
+        intervals[k] = ramp.next();
+        if (ramp.speed() > peak) peak = ramp.speed();
+    }
+    TEST_ASSERT_TRUE(ramp.finished());
+    TEST_ASSERT_EQUAL(0, intervals[299]);
+
+    // triangular profile: peaks in the middle at v = √(2as) and is symmetric around it
+    TEST_ASSERT_TRUE(peak < 2000);
+    TEST_ASSERT_FLOAT_WITHIN(10.0, sqrt(2.0 * 4000 * 150), peak);
+    for (uint32_t k = 0; k < 149; k++) {
+        TEST_ASSERT_EQUAL(intervals[k], intervals[298 - k]);
+    }
+}
+
+void test_abort_ends_at_once() {
+    XRTLramp ramp;
+    ramp.configure(2000, 4000, TICKS);
+    ramp.start(5000);
+    for (uint32_t k = 0; k < 1500; k++) {
+        ramp.next();
+    }
+    ramp.abort();
+    TEST_ASSERT_TRUE(ramp.finished());
+    TEST_ASSERT_EQUAL(0, ramp.next());
+    TEST_ASSERT_EQUAL(1500, ramp.performed());
+    TEST_ASSERT_EQUAL(1500, ramp.planned());
+
+    // the next move starts without the abort
+    ramp.start(10);
+    uint32_t steps;
+    run(ramp, steps);
+    TEST_ASSERT_EQUAL(10, steps);
+}
+
+void test_benchmark() {
+    XRTLramp ramp;
+    ramp.configure(40000, 100000, TICKS);
+    uint32_t steps = 0;
+    uint64_t total = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_RUNS; i++) {
+        ramp.start(50000);
+        uint32_t performed;
+        total += run(ramp, performed);
+        steps += performed;
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    TEST_ASSERT_TRUE(total > 0);
+
+    // host time only, shows the cost of the computed part beyond the table
+    char message[64];
+    snprintf(message, sizeof(message), "%.1f ns per step", std::chrono::duration<double, std::nano>(elapsed).count() / steps);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_square_root);
+    RUN_TEST(test_duration_matches_steps);
+    RUN_TEST(test_stop_brakes_from_cruise);
+    RUN_TEST(test_stop_while_accelerating);
+    RUN_TEST(test_short_move_never_cruises);
+    RUN_TEST(test_abort_ends_at_once);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
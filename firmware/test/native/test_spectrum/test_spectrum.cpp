@@ -0,0 +1,159 @@
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+
+#include "modules/input/XRTLspectrum.cpp"
+
+#define BENCHMARK_RUNS 100
+
+static uint32_t noiseState = 12345;
+
+/**
+ * @returns uniformly distributed noise in [-1, 1), reproducible between runs
+ */
+static double noise() {
+    noiseState = noiseState * 1664525 + 1013904223;
+    return ((double)(noiseState >> 8) / (1 << 24)) * 2.0 - 1.0;
+}
+
+/**
+ * @brief record a synthetic signal: DC, two sines and noise
+ * @param spectrum configured spectrum, a full record is pushed
+ * @param samples receives the samples as pushed; mV (Q4)
+ */
+static void record(XRTLspectrum &spectrum, uint16_t *samples) {
+    uint32_t length = spectrum.transformLength();
+    spectrum.start();
+    for (uint32_t n = 0; n < length; n++) {
+        double milliVolts = 1200.0 + 300.0 * cos(2.0 * M_PI * 37.25 * n / length + 0.3);
+        milliVolts += 40.0 * sin(2.0 * M_PI * (length / 8) * n / length) + 5.0 * noise();
+        samples[n] = (uint16_t)lround(milliVolts * (1 << SPECTRUM_FRACTION));
+        spectrum.push(samples[n], 1000 + n);
+    }
+}
+
+/**
+ * @brief amplitude spectrum as defined by XRTLspectrum::compute(), evaluated by a direct DFT in double precision
+ * @param samples record; mV (Q4)
+ * @param length number of samples
+ * @param magnitude receives length / 2 + 1 amplitudes; mV
+ */
+static void directSpectrum(const uint16_t *samples, uint32_t length, double *magnitude) {
+    double mean = 0.0;
+    for (uint32_t n = 0; n < length; n++) {
+        mean += (double)samples[n] / (1 << SPECTRUM_FRACTION);
+    }
+    mean /= length;
+
+    for (uint32_t k = 1; k <= length / 2; k++) {
+        double re = 0.0;
+        double im = 0.0;
+        for (uint32_t n = 0; n < length; n++) {
+            double window = 0.5 - 0.5 * cos(2.0 * M_PI * n / length);
+            double sample = window * ((double)samples[n] / (1 << SPECTRUM_FRACTION) - mean);
+            re += sample * cos(2.0 * M_PI * k * n / length);
+            im -= sample * sin(2.0 * M_PI * k * n / length);
+        }
+        magnitude[k] = sqrt(re * re + im * im) * 4.0 / length;
+    }
+    magnitude[length / 2] /= 2;
+    magnitude[0] = mean;
+}
+
+void test_configure_rounds_length() {
+    XRTLspectrum spectrum;
+    TEST_ASSERT_TRUE(spectrum.configure(1000));
+    TEST_ASSERT_EQUAL(512, spectrum.transformLength());
+    TEST_ASSERT_EQUAL(257, spectrum.bins());
+    TEST_ASSERT_TRUE(spectrum.configure(10));
+    TEST_ASSERT_EQUAL(SPECTRUM_MIN_LENGTH, spectrum.transformLength());
+    TEST_ASSERT_TRUE(spectrum.configure(100000));
+    TEST_ASSERT_EQUAL(SPECTRUM_MAX_LENGTH, spectrum.transformLength());
+}
+
+void test_record_completes() {
+    XRTLspectrum spectrum;
+    spectrum.configure(64);
+    TEST_ASSERT_FALSE(spectrum.complete());
+
+    uint16_t samples[64];
+    record(spectrum, samples);
+    TEST_ASSERT_FALSE(spectrum.active());
+    TEST_ASSERT_TRUE(spectrum.complete());
+    TEST_ASSERT_EQUAL(1000, spectrum.firstSample());
+
+    spectrum.push(0, 2000); // ignored after the record is complete
+    spectrum.compute();
+    TEST_ASSERT_FALSE(spectrum.complete());
+}
+
+void test_matches_direct_dft() {
+    for (uint32_t length = SPECTRUM_MIN_LENGTH; length <= SPECTRUM_MAX_LENGTH; length *= 4) {
+        XRTLspectrum spectrum;
+        spectrum.configure(length);
+        uint16_t *samples = new uint16_t[length];
+        double *expected = new double[length / 2 + 1];
+        record(spectrum, samples);
+        spectrum.compute();
+        directSpectrum(samples, length, expected);
+
+        // single precision: the error is relative to the strongest bin
+        const float *amplitudes = spectrum.amplitudes();
+        for (uint32_t k = 0; k < spectrum.bins(); k++) {
+            TEST_ASSERT_FLOAT_WITHIN(0.01, expected[k], amplitudes[k]);
+        }
+        delete[] samples;
+        delete[] expected;
+    }
+}
+
+void test_finds_peaks() {
+    XRTLspectrum spectrum;
+    spectrum.configure(1024);
+    uint16_t samples[1024];
+    record(spectrum, samples);
+    spectrum.compute();
+
+    float bin[SPECTRUM_MAX_PEAKS];
+    float amplitude[SPECTRUM_MAX_PEAKS];
+    uint8_t found = spectrum.peaks(2, bin, amplitude);
+    TEST_ASSERT_EQUAL(2, found);
+
+    // the parabolic interpolation of a Hann window is accurate to a few percent of a bin
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 37.25, bin[0]);
+    TEST_ASSERT_FLOAT_WITHIN(300.0 * 0.05, 300.0, amplitude[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 128.0, bin[1]);
+    TEST_ASSERT_FLOAT_WITHIN(40.0 * 0.01, 40.0, amplitude[1]);
+    TEST_ASSERT_FLOAT_WITHIN(2.0, 1200.0, spectrum.average()); // the sine between two bins does not average out
+}
+
+void test_benchmark() {
+    XRTLspectrum spectrum;
+    spectrum.configure(SPECTRUM_MAX_LENGTH);
+    uint16_t samples[SPECTRUM_MAX_LENGTH];
+
+    std::chrono::nanoseconds total(0);
+    for (int i = 0; i < BENCHMARK_RUNS; i++) {
+        record(spectrum, samples);
+        auto start = std::chrono::steady_clock::now();
+        spectrum.compute();
+        total += std::chrono::steady_clock::now() - start;
+    }
+
+    // host time only, the device reports its own compute time as spectrumTime in the status
+    char message[64];
+    snprintf(message, sizeof(message), "%d samples: %.1f us per spectrum", SPECTRUM_MAX_LENGTH,
+             std::chrono::duration<double, std::micro>(total).count() / BENCHMARK_RUNS);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_configure_rounds_length);
+    RUN_TEST(test_record_completes);
+    RUN_TEST(test_matches_direct_dft);
+    RUN_TEST(test_finds_peaks);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+
+#include "modules/input/conversions/thermistor/ThermistorTable.cpp"
+
+#define TEMP_NORMAL 298.15 // K
+#define RES_NORMAL 10.0    // kOhm
+#define BETA 3950.0        // K
+#define BENCHMARK_RUNS 1000000
+
+/**
+ * @brief beta formula of an NTC in double precision, independent of the tested class
+ * @param resistance kOhm
+ * @returns temperature; K
+ */
+static double analytic(double resistance) {
+    return 1.0 / (log(resistance / RES_NORMAL) / BETA + 1.0 / TEMP_NORMAL);
+}
+
+/**
+ * @brief interpolation error of the table as documented in ThermistorTable.h
+ * @param temperature K
+ * @returns maximum error; K
+ */
+static double documentedError(double temperature) {
+    return temperature * temperature * (1.0 + 2.0 * temperature / BETA) / (8192.0 * BETA);
+}
+
+void test_rejects_invalid_settings() {
+    ThermistorTable thermistor;
+    TEST_ASSERT_FALSE(thermistor.build(TEMP_NORMAL, 0.0, BETA));
+    TEST_ASSERT_FALSE(thermistor.build(TEMP_NORMAL, RES_NORMAL, 0.0));
+    TEST_ASSERT_FALSE(thermistor.build(0.0, RES_NORMAL, BETA));
+
+    // falls back to the exact formula
+    thermistor.build(TEMP_NORMAL, -RES_NORMAL, BETA);
+    TEST_ASSERT_TRUE(isnan(thermistor.convert(5.0)));
+    TEST_ASSERT_TRUE(thermistor.build(TEMP_NORMAL, RES_NORMAL, BETA));
+}
+
+void test_nodes_are_exact() {
+    ThermistorTable thermistor;
+    thermistor.build(TEMP_NORMAL, RES_NORMAL, BETA);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, TEMP_NORMAL, thermistor.convert(RES_NORMAL));
+    for (int octave = -THERMISTOR_OCTAVES / 2; octave < THERMISTOR_OCTAVES / 2; octave++) {
+        double resistance = ldexp(RES_NORMAL, octave);
+        TEST_ASSERT_FLOAT_WITHIN(analytic(resistance) * 1e-6, analytic(resistance), thermistor.convert(resistance));
+    }
+}
+
+void test_interpolation_within_documented_error() {
+    ThermistorTable thermistor;
+    thermistor.build(TEMP_NORMAL, RES_NORMAL, BETA);
+
+    // sweep the whole table with a step that is not commensurate with the segments
+    double worst = 0.0;
+    double worstTemperature = 0.0;
+    double lowest = ldexp(RES_NORMAL, -THERMISTOR_OCTAVES / 2);
+    double highest = ldexp(RES_NORMAL, THERMISTOR_OCTAVES / 2);
+    for (double resistance = lowest; resistance < highest; resistance *= 1.000123) {
+        double expected = analytic(resistance);
+        double error = fabs(thermistor.convert(resistance) - expected);
+
+        // single precision rounding of the resistance and the table adds a few µK on top of the interpolation
+        TEST_ASSERT_TRUE(error <= documentedError(expected) * 1.05 + expected * 1e-7);
+        if (error > worst) {
+            worst = error;
+            worstTemperature = expected;
+        }
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "worst error %.2f mK at %.0f K", worst * 1000.0, worstTemperature);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst < 0.011); // 10 mK at 240 °C as documented
+}
+
+void test_outside_table_is_exact() {
+    ThermistorTable thermistor;
+    thermistor.build(TEMP_NORMAL, RES_NORMAL, BETA);
+    const double resistances[] = {ldexp(RES_NORMAL, -9), ldexp(RES_NORMAL, 8), ldexp(RES_NORMAL, 12)};
+    for (double resistance : resistances) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-9, analytic(resistance), thermistor.convert(resistance));
+    }
+    TEST_ASSERT_TRUE(isnan(thermistor.convert(-1.0))); // the sign bit leads out of the table as well
+}
+
+void test_benchmark() {
+    ThermistorTable thermistor;
+    thermistor.build(TEMP_NORMAL, RES_NORMAL, BETA);
+
+    // both paths consume their results to keep the loops from being optimized away
+    volatile double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_RUNS; i++) {
+        sink = sink + thermistor.convert(1.0 + (i & 1023) * 0.05);
+    }
+    auto table = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_RUNS; i++) {
+        sink = sink + thermistor.exact(1.0 + (i & 1023) * 0.05);
+    }
+    auto formula = std::chrono::steady_clock::now() - start;
+
+    // host time only, the ratio on the device is larger: it has no double precision FPU
+    char message[80];
+    snprintf(message, sizeof(message), "table %.1f ns, formula %.1f ns per conversion",
+             std::chrono::duration<double, std::nano>(table).count() / BENCHMARK_RUNS,
+             std::chrono::duration<double, std::nano>(formula).count() / BENCHMARK_RUNS);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_invalid_settings);
+    RUN_TEST(test_nodes_are_exact);
+    RUN_TEST(test_interpolation_within_documented_error);
+    RUN_TEST(test_outside_table_is_exact);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}